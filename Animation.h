@@ -0,0 +1,490 @@
+#pragma once
+#include <cmath>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <GL/glew.h>
+#include "Matrix.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// 四元数 (x, y, z, w) の球面線形補間
+// acos と sin を使わない多項式近似 (D. Eberly, "A Fast and Accurate Algorithm for Computing SLERP")
+struct Slerp
+{
+	static constexpr int terms = 8;
+
+	static GLfloat u(int i)
+	{
+		static const GLfloat mu(1.85298109240830f);
+		return i < terms - 1 ? 1.f / ((i + 1) * (2 * i + 3)) : mu / ((i + 1) * (2 * i + 3));
+	}
+
+	static GLfloat v(int i)
+	{
+		static const GLfloat mu(1.85298109240830f);
+		return i < terms - 1 ? static_cast<GLfloat>(i + 1) / (2 * i + 3) : mu * (i + 1) / (2 * i + 3);
+	}
+
+	// dot(q0, q1) = x >= 0 のときの q0 と q1 の係数
+	static void coefficient(GLfloat x, GLfloat t, GLfloat& c0, GLfloat& c1)
+	{
+		const GLfloat xm1(x - 1.f), d(1.f - t);
+		GLfloat bt(1.f), bd(1.f);
+		for (int i = terms - 1; i >= 0; --i)
+		{
+			bt = 1.f + (u(i) * t * t - v(i)) * xm1 * bt;
+			bd = 1.f + (u(i) * d * d - v(i)) * xm1 * bd;
+		}
+		c0 = d * bd;
+		c1 = t * bt;
+	}
+
+	// 1 組の補間 (SIMD のないときと検証用)
+	static void scalar(const GLfloat* q0, const GLfloat* q1, GLfloat t, GLfloat* q)
+	{
+		GLfloat x(q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3]);
+		const GLfloat s(x < 0.f ? -1.f : 1.f);
+		x *= s;
+
+		GLfloat c0, c1;
+		coefficient(x, t, c0, c1);
+		for (int k = 0; k < 4; ++k) q[k] = c0 * q0[k] + s * c1 * q1[k];
+	}
+
+	// acos と sin による補間 (検証用)
+	static void reference(const GLfloat* q0, const GLfloat* q1, GLfloat t, GLfloat* q)
+	{
+		double x(q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3]);
+		const double s(x < 0.0 ? -1.0 : 1.0);
+		x = std::min(x * s, 1.0);
+
+		const double a(acos(x)), sa(sin(a));
+		const double c0(sa > 1e-9 ? sin((1.0 - t) * a) / sa : 1.0 - t);
+		const double c1(sa > 1e-9 ? sin(t * a) / sa : t);
+		for (int k = 0; k < 4; ++k) q[k] = static_cast<GLfloat>(c0 * q0[k] + s * c1 * q1[k]);
+	}
+
+#if defined(__SSE2__) || defined(_M_X64)
+	// 4 組をまとめて補間する (各要素を 4 組分ずつ並べた SoA)
+	static void simd(const __m128* q0, const __m128* q1, __m128 t, __m128* q)
+	{
+		const __m128 one(_mm_set1_ps(1.f));
+		const __m128 sign(_mm_set1_ps(-0.f));
+
+		__m128 x(_mm_add_ps(_mm_add_ps(_mm_mul_ps(q0[0], q1[0]), _mm_mul_ps(q0[1], q1[1])),
+			_mm_add_ps(_mm_mul_ps(q0[2], q1[2]), _mm_mul_ps(q0[3], q1[3]))));
+
+		// 内積が負なら q1 の符号を反転して短い方の弧をとる
+		const __m128 flip(_mm_and_ps(x, sign));
+		x = _mm_xor_ps(x, flip);
+
+		const __m128 xm1(_mm_sub_ps(x, one)), d(_mm_sub_ps(one, t));
+		const __m128 t2(_mm_mul_ps(t, t)), d2(_mm_mul_ps(d, d));
+		__m128 bt(one), bd(one);
+		for (int i = terms - 1; i >= 0; --i)
+		{
+			const __m128 ui(_mm_set1_ps(u(i))), vi(_mm_set1_ps(v(i)));
+			bt = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ui, t2), vi), xm1), bt));
+			bd = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ui, d2), vi), xm1), bd));
+		}
+		const __m128 c0(_mm_mul_ps(d, bd));
+		const __m128 c1(_mm_xor_ps(_mm_mul_ps(t, bt), flip));
+
+		for (int k = 0; k < 4; ++k)
+			q[k] = _mm_add_ps(_mm_mul_ps(c0, q0[k]), _mm_mul_ps(c1, q1[k]));
+	}
+#endif
+};
+
+// 関節の階層
+struct Skeleton
+{
+	std::vector<GLint> parent;       // 親の関節の番号 (親は子より前、根は -1)
+	std::vector<Matrix> inverseBind; // 基本姿勢のワールド座標系から関節の座標系への変換
+
+	GLsizei size() const
+	{
+		return static_cast<GLsizei>(parent.size());
+	}
+};
+
+// 一定の間隔で標本化したキーフレームを 16 ビットに量子化して持つ
+// 4 関節ずつ各要素を並べて SIMD でそのまま読めるようにしてある
+class AnimationClip
+{
+	GLsizei joints;   // 関節の数
+	GLsizei blocks;   // 4 関節ずつのまとまりの数
+	GLsizei frames;   // キーフレームの数
+	GLfloat fps;      // 1 秒あたりのキーフレーム数
+
+	// [frame][block][x, y, z, w][4 関節]
+	std::vector<GLshort> rotation;
+
+	// [frame][block][x, y, z][4 関節] と関節ごとの最小値と刻み幅
+	std::vector<GLshort> translation;
+	std::vector<GLfloat> base, step;
+
+public:
+	// joints: 関節の数
+	// frames: キーフレームの数 (0 なら基本姿勢だけの 1 フレームのクリップになる)
+	// fps: 1 秒あたりのキーフレーム数
+	// rotation: [frame][joint] の順の回転の四元数 (x, y, z, w)
+	// translation: [frame][joint] の順の平行移動 (x, y, z)
+	AnimationClip(
+		GLsizei joints,
+		GLsizei frames,
+		GLfloat fps,
+		const GLfloat* rotation,
+		const GLfloat* translation)
+	 : joints(joints),
+	   blocks((joints + 3) / 4),
+	   frames(std::max(frames, 1)),
+	   fps(fps),
+	   rotation(this->frames * blocks * 16, 0),
+	   translation(this->frames * blocks * 12, 0),
+	   base(blocks * 12, 0.f),
+	   step(blocks * 12, 0.f)
+	{
+		// キーフレームがなければ sample() の剰余が 0 除算になるので基本姿勢を 1 フレーム置く
+		if (frames <= 0)
+		{
+			std::cerr << "Error: Animation clip has no key frames" << std::endl;
+			for (GLsizei j = 0; j < blocks * 4; ++j)
+				this->rotation[j / 4 * 16 + 12 + j % 4] = 32767;
+			return;
+		}
+
+		// 平行移動の範囲を関節と要素ごとに求める
+		for (GLsizei j = 0; j < joints; ++j)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				GLfloat lo(HUGE_VALF), hi(-HUGE_VALF);
+				for (GLsizei f = 0; f < frames; ++f)
+				{
+					lo = std::min(lo, translation[(f * joints + j) * 3 + k]);
+					hi = std::max(hi, translation[(f * joints + j) * 3 + k]);
+				}
+				base[soa(j, k)] = lo;
+				step[soa(j, k)] = (hi - lo) / 65535.f;
+			}
+		}
+
+		for (GLsizei f = 0; f < frames; ++f)
+		{
+			for (GLsizei j = 0; j < joints; ++j)
+			{
+				GLfloat q[4];
+				std::copy(rotation + (f * joints + j) * 4, rotation + (f * joints + j) * 4 + 4, q);
+				const GLfloat l(sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]));
+				for (int k = 0; k < 4; ++k)
+					this->rotation[f * blocks * 16 + j / 4 * 16 + k * 4 + j % 4] = static_cast<GLshort>(floor(q[k] / l * 32767.f + 0.5f));
+
+				for (int k = 0; k < 3; ++k)
+				{
+					const GLsizei s(soa(j, k));
+					const GLfloat v(step[s] > 0.f ? (translation[(f * joints + j) * 3 + k] - base[s]) / step[s] : 0.f);
+					this->translation[f * blocks * 12 + s] = static_cast<GLshort>(floor(v + 0.5f) - 32768.f);
+				}
+			}
+
+			// 余りの関節は単位四元数にする
+			for (GLsizei j = joints; j < blocks * 4; ++j)
+				this->rotation[f * blocks * 16 + j / 4 * 16 + 12 + j % 4] = 32767;
+		}
+	}
+
+private:
+	// 4 関節ずつ並べたときの関節 j の要素 k の位置
+	static GLsizei soa(GLsizei j, int k)
+	{
+		return j / 4 * 12 + k * 4 + j % 4;
+	}
+
+public:
+	/*
+	 * @brief 時刻 time の姿勢を求める (繰り返し再生)
+	 * @param time:        時刻 (秒)
+	 * @param rotation:    関節ごとの回転の四元数 (x, y, z, w の順に 4 関節ずつ並べた SoA)
+	 * @param translation: 関節ごとの平行移動 (x, y, z の順に 4 関節ずつ並べた SoA)
+	 */
+	void sample(GLfloat time, GLfloat* rotation, GLfloat* translation) const
+	{
+		const GLfloat position(std::max(time * fps, 0.f));
+		const GLsizei f0(static_cast<GLsizei>(position) % frames), f1((f0 + 1) % frames);
+		const GLfloat t(position - floor(position));
+
+		const GLshort* const r0(&this->rotation[f0 * blocks * 16]);
+		const GLshort* const r1(&this->rotation[f1 * blocks * 16]);
+		const GLshort* const p0(&this->translation[f0 * blocks * 12]);
+		const GLshort* const p1(&this->translation[f1 * blocks * 12]);
+
+		GLsizei b(0);
+#if defined(__SSE2__) || defined(_M_X64)
+		const __m128 vt(_mm_set1_ps(t));
+		const __m128 qscale(_mm_set1_ps(1.f / 32767.f));
+		const __m128 bias(_mm_set1_ps(32768.f));
+
+		for (; b < blocks; ++b)
+		{
+			// 16 ビット整数を符号拡張して浮動小数点数に戻す
+			__m128 q0[4], q1[4], q[4];
+			for (int h = 0; h < 2; ++h)
+			{
+				const __m128i a(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + b * 16 + h * 8)));
+				const __m128i c(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + b * 16 + h * 8)));
+				q0[h * 2 + 0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16)), qscale);
+				q0[h * 2 + 1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16)), qscale);
+				q1[h * 2 + 0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16)), qscale);
+				q1[h * 2 + 1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(c, c), 16)), qscale);
+			}
+
+			Slerp::simd(q0, q1, vt, q);
+			for (int k = 0; k < 4; ++k) _mm_storeu_ps(rotation + b * 16 + k * 4, q[k]);
+
+			for (int k = 0; k < 3; ++k)
+			{
+				const __m128i a(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p0 + b * 12 + k * 4)));
+				const __m128i c(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p1 + b * 12 + k * 4)));
+				const __m128 v0(_mm_add_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16)), bias));
+				const __m128 v1(_mm_add_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16)), bias));
+				const __m128 v(_mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), vt)));
+				_mm_storeu_ps(translation + b * 12 + k * 4,
+					_mm_add_ps(_mm_loadu_ps(&base[b * 12 + k * 4]), _mm_mul_ps(v, _mm_loadu_ps(&step[b * 12 + k * 4]))));
+			}
+		}
+#endif
+		for (; b < blocks; ++b)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				GLfloat q0[4], q1[4], q[4];
+				for (int k = 0; k < 4; ++k)
+				{
+					q0[k] = r0[b * 16 + k * 4 + j] / 32767.f;
+					q1[k] = r1[b * 16 + k * 4 + j] / 32767.f;
+				}
+				Slerp::scalar(q0, q1, t, q);
+				for (int k = 0; k < 4; ++k) rotation[b * 16 + k * 4 + j] = q[k];
+
+				for (int k = 0; k < 3; ++k)
+				{
+					const GLsizei s(b * 12 + k * 4 + j);
+					const GLfloat v0(p0[s] + 32768.f), v1(p1[s] + 32768.f);
+					translation[s] = base[s] + (v0 + (v1 - v0) * t) * step[s];
+				}
+			}
+		}
+	}
+
+	GLsizei getJointCount() const { return joints; }
+
+	// sample() に渡す配列の要素数
+	GLsizei getRotationSize() const { return blocks * 16; }
+
+	GLsizei getTranslationSize() const { return blocks * 12; }
+
+	GLfloat getDuration() const { return frames / fps; }
+};
+
+// 1 体分の姿勢
+struct Character
+{
+	const Skeleton* skeleton;
+	const AnimationClip* clip;
+	GLfloat time;
+
+	// スキニングに使う関節ごとの変換行列
+	std::vector<Matrix> skin;
+
+	// skeleton: 関節の階層
+	// clip: 再生するクリップ (関節の数は skeleton と同じにする)
+	// time: 時刻 (秒)
+	Character(const Skeleton* skeleton, const AnimationClip* clip, GLfloat time = 0.f)
+	 : skeleton(skeleton),
+	   clip(clip),
+	   time(time)
+	{
+		// 関節の数が違えば少ない方だけ求める
+		if (skeleton->size() != clip->getJointCount())
+			std::cerr << "Error: Animation clip has " << clip->getJointCount()
+				<< " joints but the skeleton has " << skeleton->size() << std::endl;
+	}
+
+	/*
+	 * @brief 時刻 time の姿勢から関節ごとの変換行列を求める
+	 *        関節の数が skeleton と clip で違えば少ない方の数だけ求める
+	 * @param rotation, translation: 作業用の配列
+	 */
+	void evaluate(std::vector<GLfloat>& rotation, std::vector<GLfloat>& translation)
+	{
+		rotation.resize(clip->getRotationSize());
+		translation.resize(clip->getTranslationSize());
+		clip->sample(time, rotation.data(), translation.data());
+
+		// 親から順に関節の座標系を合成する
+		const GLsizei joints(std::min(skeleton->size(), clip->getJointCount()));
+		std::vector<Matrix>& world(skin);
+		world.resize(joints);
+		for (GLsizei j = 0; j < joints; ++j)
+		{
+			const GLfloat* const r(&rotation[j / 4 * 16 + j % 4]);
+			const GLfloat* const p(&translation[j / 4 * 12 + j % 4]);
+			const GLfloat x(r[0]), y(r[4]), z(r[8]), w(r[12]);
+
+			Matrix local;
+			local[0] = 1.f - 2.f * (y * y + z * z);
+			local[1] = 2.f * (x * y + w * z);
+			local[2] = 2.f * (x * z - w * y);
+			local[3] = 0.f;
+			local[4] = 2.f * (x * y - w * z);
+			local[5] = 1.f - 2.f * (x * x + z * z);
+			local[6] = 2.f * (y * z + w * x);
+			local[7] = 0.f;
+			local[8] = 2.f * (x * z + w * y);
+			local[9] = 2.f * (y * z - w * x);
+			local[10] = 1.f - 2.f * (x * x + y * y);
+			local[11] = 0.f;
+			local[12] = p[0];
+			local[13] = p[4];
+			local[14] = p[8];
+			local[15] = 1.f;
+
+			const GLint parent(skeleton->parent[j]);
+			world[j] = parent < 0 ? local : world[parent] * local;
+		}
+
+		// 基本姿勢からの変換にする (合成はすべて終わっているので同じ配列に上書きする)
+		for (GLsizei j = 0; j < joints; ++j)
+			skin[j] = world[j] * skeleton->inverseBind[j];
+	}
+};
+
+// 多数のキャラクタの姿勢をスレッドに分けて求める
+class PoseEvaluator
+{
+	// 姿勢を求めるのを手伝うワーカースレッド
+	// 初めて複数のスレッドで evaluate() したときに作り、以後の呼び出しで使い回す
+	std::vector<std::thread> workers;
+	std::vector<std::vector<GLfloat>> rotation, translation; // スレッドごとの作業用の配列
+	std::mutex mutex;
+	std::condition_variable start, done;
+	unsigned long generation; // evaluate() の回数
+	unsigned int active;      // 今回使うスレッドの数
+	unsigned int running;     // 姿勢を求めているワーカースレッドの数
+	bool quit;
+
+	// 今回のキャラクタ
+	Character* character;
+	std::size_t count;
+
+public:
+	PoseEvaluator()
+	 : rotation(1),
+	   translation(1),
+	   generation(0),
+	   active(1),
+	   running(0),
+	   quit(false),
+	   character(NULL),
+	   count(0)
+	{}
+
+	virtual ~PoseEvaluator()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		start.notify_all();
+
+		for (std::thread& t : workers) t.join();
+	}
+
+private:
+	PoseEvaluator(const PoseEvaluator &o);
+	PoseEvaluator &operator=(const PoseEvaluator &o);
+
+	// t 番目のワーカースレッド (seen は作ったときの evaluate() の回数)
+	void work(unsigned int t, unsigned long seen)
+	{
+		for (;;)
+		{
+			unsigned int n;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				start.wait(lock, [this, seen] { return quit || generation != seen; });
+				if (quit) return;
+
+				seen = generation;
+				n = active;
+			}
+
+			// 今回使わないスレッドは次の呼び出しを待つ
+			if (t >= n) continue;
+
+			evaluateRange(t, n);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--running;
+			}
+			done.notify_one();
+		}
+	}
+
+	// n 個に分けた t 番目のキャラクタの姿勢を求める
+	void evaluateRange(unsigned int t, unsigned int n)
+	{
+		for (std::size_t i = count * t / n; i < count * (t + 1) / n; ++i)
+			character[i].evaluate(rotation[t], translation[t]);
+	}
+
+public:
+	/*
+	 * @brief キャラクタの姿勢を求める
+	 * @param character: キャラクタ
+	 * @param count:     キャラクタの数
+	 * @param threads:   使うスレッドの数 (0 ならハードウェアのスレッド数)
+	 *                   1 なら呼び出したスレッドだけで求め、2 以上ならワーカースレッドを使い回す
+	 */
+	void evaluate(Character* character, std::size_t count, unsigned int threads = 0)
+	{
+		if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+		threads = static_cast<unsigned int>(std::min<std::size_t>(threads, std::max<std::size_t>(count, 1)));
+
+		this->character = character;
+		this->count = count;
+
+		if (threads > 1)
+		{
+			if (rotation.size() < threads)
+			{
+				rotation.resize(threads);
+				translation.resize(threads);
+			}
+			while (workers.size() + 1 < threads)
+				workers.emplace_back(&PoseEvaluator::work, this, static_cast<unsigned int>(workers.size() + 1), generation);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				active = threads;
+				running = threads - 1;
+				++generation;
+			}
+			start.notify_all();
+		}
+
+		evaluateRange(0, threads);
+
+		if (threads > 1)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this] { return running == 0; });
+		}
+	}
+};
@@ -0,0 +1,303 @@
+#pragma once
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Mesh.h"
+#include "Shape.h"
+#include "SolidShape.h"
+#include "SolidShapeIndex.h"
+
+// 読み込みが終わると描画できるようになる形状
+class ShapeHandle
+{
+	std::shared_ptr<std::unique_ptr<const Shape>> shape;
+
+public:
+	ShapeHandle()
+	 : shape(std::make_shared<std::unique_ptr<const Shape>>())
+	{}
+
+	bool ready() const
+	{
+		return *shape != nullptr;
+	}
+
+	// まだ届いていなければ何もしない
+	void draw() const
+	{
+		if (*shape) (*shape)->draw();
+	}
+
+	const Shape* get() const
+	{
+		return shape->get();
+	}
+
+	friend class AssetStreamer;
+};
+
+// ファイルの読み込みと展開をワーカースレッドで行い、
+// GL への転送は描画スレッドで 1 フレームあたりの予算の範囲で行う
+// 変化があったときだけ描画するウィンドウでは redraw() より前に update() を呼び、
+// 転送したものがあれば invalidate() する
+//
+//   streamer.setNotify(glfwPostEmptyEvent);
+//   while (window)
+//   {
+//     if (streamer.update()) window.invalidate();
+//     if (!window.redraw()) continue;
+//     ...
+//   }
+class AssetStreamer
+{
+public:
+	struct Stats
+	{
+		std::size_t queued;    // 読み込み待ちと読み込み中の数
+		std::size_t ready;     // 転送待ちの数
+		std::size_t uploads;   // 直前のフレームで転送した数
+		std::size_t bytes;     // 直前のフレームで転送したバイト数
+		double uploadMs;       // 直前のフレームで転送にかかった時間
+		double latencyMs;      // 要求から転送完了までの平均時間
+		double maxLatencyMs;   // 要求から転送完了までの最大時間
+		std::size_t completed; // 転送を終えた数
+		std::size_t failed;    // 読み込みに失敗した数
+	};
+
+	// 形状データから形状を作る関数
+	typedef std::function<const Shape*(const Mesh&)> ShapeFactory;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Job
+	{
+		std::function<bool()> load;          // ワーカースレッドで実行する
+		std::function<std::size_t()> upload; // 描画スレッドで実行して転送したバイト数を返す
+		Clock::time_point requested;
+	};
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<std::shared_ptr<Job>> pending;
+	std::deque<std::shared_ptr<Job>> loaded;
+	std::size_t loading;
+	bool quit;
+
+	// 読み込みが終わったときにワーカースレッドから呼ぶ関数
+	std::function<void()> notify;
+
+	Stats stats;
+	double latencySum;
+
+public:
+	// threads: ワーカースレッドの数、0 ならハードウェアのスレッド数 - 1
+	AssetStreamer(unsigned int threads = 0)
+	 : loading(0),
+	   quit(false),
+	   stats(),
+	   latencySum(0.0)
+	{
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		for (unsigned int i = 0; i < threads; ++i)
+			workers.emplace_back(&AssetStreamer::work, this);
+	}
+
+	virtual ~AssetStreamer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		condition.notify_all();
+
+		for (std::thread& t : workers) t.join();
+	}
+
+private:
+	AssetStreamer(const AssetStreamer &o);
+	AssetStreamer &operator=(const AssetStreamer &o);
+
+	void work()
+	{
+		for (;;)
+		{
+			std::shared_ptr<Job> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return quit || !pending.empty(); });
+				if (quit) return;
+
+				job = pending.front();
+				pending.pop_front();
+				++loading;
+			}
+
+			// 読み込みの例外 (壊れたファイルでの bad_alloc など) はワーカースレッドの外に出さない
+			bool status(false);
+			try
+			{
+				status = job->load();
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "Error: Asset load failed: " << e.what() << std::endl;
+			}
+
+			std::function<void()> wake;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--loading;
+				if (status) loaded.push_back(job);
+				else ++stats.failed;
+				wake = notify;
+			}
+
+			if (status && wake) wake();
+		}
+	}
+
+public:
+	/*
+	 * @brief 読み込みが終わったときに呼ぶ関数を設定する
+	 *        イベントを待っている描画スレッドを glfwPostEmptyEvent() で起こすのに使う
+	 *        起こすだけなので、描画スレッドは update() の戻り値を見て描き直す
+	 * @param func: ワーカースレッドから呼ばれる関数
+	 */
+	void setNotify(std::function<void()> func)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		notify = func;
+	}
+
+	/*
+	 * @brief 任意のアセットの読み込みを要求する
+	 * @param load:   ワーカースレッドで実行する読み込みと展開、失敗したら false を返す
+	 * @param upload: 描画スレッドで実行する GL への転送、転送したバイト数を返す
+	 */
+	void submit(std::function<bool()> load, std::function<std::size_t()> upload)
+	{
+		const std::shared_ptr<Job> job(new Job{ load, upload, Clock::now() });
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending.push_back(job);
+		}
+		condition.notify_one();
+	}
+
+	/*
+	 * @brief 形状ファイルの読み込みを要求する
+	 * @param name:    ファイル名
+	 * @param factory: 形状データから形状を作る関数、省略時は三角形で描く
+	 * @return         転送が終わると描画できるようになるハンドル
+	 */
+	ShapeHandle loadShape(const std::string& name, ShapeFactory factory = ShapeFactory())
+	{
+		ShapeHandle handle;
+		const std::shared_ptr<Mesh> mesh(new Mesh);
+
+		if (!factory)
+		{
+			factory = [](const Mesh& m) -> const Shape*
+			{
+				const GLsizei vertexcount(static_cast<GLsizei>(m.vertex.size()));
+				const GLsizei indexcount(static_cast<GLsizei>(m.index.size()));
+
+				if (indexcount == 0) return new SolidShape(m.size, vertexcount, m.vertex.data());
+				return new SolidShapeIndex(m.size, vertexcount, m.vertex.data(), indexcount, m.index.data());
+			};
+		}
+
+		const std::shared_ptr<std::unique_ptr<const Shape>> slot(handle.shape);
+		submit(
+			[name, mesh] { return readMesh(name.c_str(), *mesh); },
+			[slot, mesh, factory]
+			{
+				slot->reset(factory(*mesh));
+				return mesh->vertex.size() * sizeof(Object::Vertex)
+					+ mesh->index.size() * Object::getIndexSize(Object::selectIndexType(static_cast<GLsizei>(mesh->vertex.size())));
+			});
+
+		return handle;
+	}
+
+	/*
+	 * @brief 読み込み済みのアセットを予算の範囲で GL に転送する
+	 *        毎フレーム描画スレッドから呼ぶ
+	 * @param ms:    1 フレームで転送に使う時間の上限 (ミリ秒)
+	 * @param bytes: 1 フレームで転送するバイト数の上限
+	 * @return       転送したものがあれば true (画面を描き直す)
+	 */
+	bool update(double ms = 2.0, std::size_t bytes = 4 << 20)
+	{
+		const Clock::time_point start(Clock::now());
+		std::size_t uploads(0), uploaded(0);
+		double latencyTotal(0.0), latencyMax(0.0);
+
+		for (;;)
+		{
+			std::shared_ptr<Job> job;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (loaded.empty()) break;
+
+				job = loaded.front();
+				loaded.pop_front();
+			}
+
+			uploaded += job->upload();
+			++uploads;
+
+			const Clock::time_point now(Clock::now());
+			const double latency(std::chrono::duration<double, std::milli>(now - job->requested).count());
+			latencyTotal += latency;
+			latencyMax = std::max(latencyMax, latency);
+
+			// 少なくとも 1 つは転送して予算を使い切ったら次のフレームに回す
+			if (std::chrono::duration<double, std::milli>(now - start).count() >= ms || uploaded >= bytes) break;
+		}
+
+		const double uploadMs(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+		// 統計は getStats() と同じくロックして書き換える
+		std::lock_guard<std::mutex> lock(mutex);
+		latencySum += latencyTotal;
+		stats.maxLatencyMs = std::max(stats.maxLatencyMs, latencyMax);
+		stats.completed += uploads;
+		stats.uploads = uploads;
+		stats.bytes = uploaded;
+		stats.uploadMs = uploadMs;
+		stats.latencyMs = stats.completed > 0 ? latencySum / stats.completed : 0.0;
+
+		return uploads > 0;
+	}
+
+	// 読み込み待ちと転送待ちがなくなったか
+	bool idle()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return pending.empty() && loaded.empty() && loading == 0;
+	}
+
+	Stats getStats()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Stats s(stats);
+		s.queued = pending.size() + loading;
+		s.ready = loaded.size();
+		return s;
+	}
+
+};
@@ -0,0 +1,390 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <GL/glew.h>
+#include "Object.h"
+
+// 軸に平行な境界ボックス
+struct Aabb
+{
+	GLfloat lo[3];
+	GLfloat hi[3];
+
+	void reset()
+	{
+		std::fill(lo, lo + 3, std::numeric_limits<GLfloat>::max());
+		std::fill(hi, hi + 3, -std::numeric_limits<GLfloat>::max());
+	}
+
+	void extend(const GLfloat* p)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			lo[k] = std::min(lo[k], p[k]);
+			hi[k] = std::max(hi[k], p[k]);
+		}
+	}
+
+	void extend(const Aabb& b)
+	{
+		if (b.lo[0] > b.hi[0]) return;
+
+		extend(b.lo);
+		extend(b.hi);
+	}
+
+	// 表面積の半分
+	GLfloat area() const
+	{
+		const GLfloat dx(hi[0] - lo[0]), dy(hi[1] - lo[1]), dz(hi[2] - lo[2]);
+		return dx < 0.f ? 0.f : dx * dy + dy * dz + dz * dx;
+	}
+
+	GLfloat center(int k) const
+	{
+		return (lo[k] + hi[k]) * 0.5f;
+	}
+
+	/*
+	 * @brief 半直線と交差する区間の入口を求める
+	 * @param origin:  半直線の始点
+	 * @param inverse: 半直線の方向の各要素の逆数
+	 * @param tmax:    これより遠い交差は無視する
+	 * @return         入口までの距離、交差しなければ tmax 以上の値
+	 */
+	GLfloat intersect(const GLfloat* origin, const GLfloat* inverse, GLfloat tmax) const
+	{
+		GLfloat t0(0.f), t1(tmax);
+		for (int k = 0; k < 3; ++k)
+		{
+			const GLfloat a((lo[k] - origin[k]) * inverse[k]);
+			const GLfloat b((hi[k] - origin[k]) * inverse[k]);
+
+			// NaN は比較で落ちるように書く
+			t0 = std::max(t0, std::min(a, b));
+			t1 = std::min(t1, std::max(a, b));
+		}
+
+		return t0 <= t1 ? t0 : std::numeric_limits<GLfloat>::max();
+	}
+};
+
+// 走査に使うスタックの大きさ (buildBvh は深さをこれに収める)
+const int bvhStackSize(80);
+
+// 平坦化した BVH の節点 (32 バイト)
+// count が 0 なら内部節点で、左の子はこの直後、右の子は index の位置にある
+// count が 0 でなければ葉で、index から count 個のプリミティブを持つ
+struct BvhNode
+{
+	Aabb box;
+	GLuint index;
+	GLuint count;
+};
+
+/*
+ * @brief ビン分割の表面積ヒューリスティック (SAH) で BVH を作る
+ * @param box:      各プリミティブの境界ボックス
+ * @param node:     深さ優先の順に並べた節点
+ * @param order:    葉から参照するプリミティブの番号
+ * @param leafSize: これ以下なら分割しない
+ */
+inline void buildBvh(
+	const std::vector<Aabb>& box,
+	std::vector<BvhNode>& node,
+	std::vector<GLuint>& order,
+	GLuint leafSize = 4)
+{
+	const int bins(16);
+	const GLuint maxLeafSize(16);
+	const GLuint maxSahDepth(32);
+
+	node.clear();
+	order.resize(box.size());
+	for (GLuint i = 0; i < order.size(); ++i) order[i] = i;
+	if (box.empty()) return;
+
+	node.reserve(box.size() * 2);
+
+	struct Range
+	{
+		GLuint parent;
+		GLuint first;
+		GLuint count;
+		GLuint depth;
+	};
+	std::vector<Range> stack(1, Range{ ~0u, 0, static_cast<GLuint>(box.size()), 0 });
+
+	while (!stack.empty())
+	{
+		const Range r(stack.back());
+		stack.pop_back();
+
+		// 右の子は親に位置を記録する
+		const GLuint self(static_cast<GLuint>(node.size()));
+		if (r.parent != ~0u) node[r.parent].index = self;
+
+		BvhNode n;
+		n.box.reset();
+		Aabb centroid;
+		centroid.reset();
+		for (GLuint i = r.first; i < r.first + r.count; ++i)
+		{
+			const Aabb& b(box[order[i]]);
+			const GLfloat c[] = { b.center(0), b.center(1), b.center(2) };
+			n.box.extend(b);
+			centroid.extend(c);
+		}
+		n.index = r.first;
+		n.count = r.count;
+		node.push_back(n);
+
+		if (r.count <= leafSize) continue;
+
+		// 各軸のビンで分割したときのコストを比べる
+		int bestAxis(-1), bestSplit(0);
+		GLfloat bestCost(r.count * n.box.area());
+
+		for (int k = 0; k < 3; ++k)
+		{
+			const GLfloat extent(centroid.hi[k] - centroid.lo[k]);
+			if (extent <= 0.f) continue;
+
+			Aabb binBox[bins];
+			GLuint binCount[bins] = {};
+			for (int b = 0; b < bins; ++b) binBox[b].reset();
+
+			const GLfloat scale(bins / extent);
+			for (GLuint i = r.first; i < r.first + r.count; ++i)
+			{
+				const Aabb& b(box[order[i]]);
+				const int j(std::min(bins - 1, static_cast<int>((b.center(k) - centroid.lo[k]) * scale)));
+				binBox[j].extend(b);
+				++binCount[j];
+			}
+
+			GLfloat rightArea[bins];
+			GLuint rightCount[bins];
+			Aabb acc;
+			acc.reset();
+			GLuint count(0);
+			for (int b = bins - 1; b > 0; --b)
+			{
+				if (binCount[b] > 0) acc.extend(binBox[b]);
+				count += binCount[b];
+				rightArea[b] = acc.area();
+				rightCount[b] = count;
+			}
+
+			acc.reset();
+			count = 0;
+			for (int b = 0; b < bins - 1; ++b)
+			{
+				if (binCount[b] > 0) acc.extend(binBox[b]);
+				count += binCount[b];
+				if (count == 0 || rightCount[b + 1] == 0) continue;
+
+				const GLfloat cost(count * acc.area() + rightCount[b + 1] * rightArea[b + 1]);
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = k;
+					bestSplit = b;
+				}
+			}
+		}
+
+		// 深くなりすぎたら中央で分けて走査用のスタックに収める
+		if (r.depth >= maxSahDepth) bestAxis = -1;
+
+		GLuint mid(r.first);
+		if (bestAxis >= 0)
+		{
+			const GLfloat lo(centroid.lo[bestAxis]);
+			const GLfloat scale(bins / (centroid.hi[bestAxis] - lo));
+			mid = static_cast<GLuint>(std::partition(order.begin() + r.first, order.begin() + r.first + r.count,
+				[&](GLuint i)
+				{
+					return std::min(bins - 1, static_cast<int>((box[i].center(bestAxis) - lo) * scale)) <= bestSplit;
+				}) - order.begin());
+		}
+		else if (r.count > maxLeafSize || r.depth >= maxSahDepth)
+		{
+			// 分割しても得にならなくても葉が大きすぎれば中央で分ける
+			int k(0);
+			for (int j = 1; j < 3; ++j)
+				if (centroid.hi[j] - centroid.lo[j] > centroid.hi[k] - centroid.lo[k]) k = j;
+
+			mid = r.first + r.count / 2;
+			std::nth_element(order.begin() + r.first, order.begin() + mid, order.begin() + r.first + r.count,
+				[&](GLuint a, GLuint b) { return box[a].center(k) < box[b].center(k); });
+		}
+		else continue;
+
+		// 内部節点にして左の子を先に作る
+		node[self].count = 0;
+		stack.push_back(Range{ self, mid, r.first + r.count - mid, r.depth + 1 });
+		stack.push_back(Range{ ~0u, r.first, mid - r.first, r.depth + 1 });
+	}
+}
+
+// 1 つの形状の三角形に対する BVH
+class MeshBvh
+{
+public:
+	struct Hit
+	{
+		GLuint triangle;  // 元のインデックス配列での三角形の番号
+		GLfloat t;        // 始点からの距離 (方向ベクトルの長さが単位)
+		GLfloat u, v;     // 重心座標 (頂点 0 の重みは 1 - u - v)
+	};
+
+private:
+	std::vector<BvhNode> node;
+	std::vector<GLuint> triangle;
+
+	// 葉の順に並べた三角形の頂点 0 と 2 辺 (9 要素ずつ)
+	std::vector<GLfloat> edge;
+
+public:
+	// vertex: 頂点属性を格納した配列
+	// indexcount: 頂点のインデックスの要素数
+	// index: 頂点のインデックスを格納した配列 (NULL なら頂点を順に 3 つずつ使う)
+	MeshBvh(
+		const Object::Vertex* vertex,
+		GLsizei indexcount,
+		const GLuint* index = NULL,
+		GLuint leafSize = 4)
+	{
+		const GLsizei count(indexcount / 3);
+		std::vector<Aabb> box(count);
+		for (GLsizei i = 0; i < count; ++i)
+		{
+			box[i].reset();
+			for (int k = 0; k < 3; ++k)
+				box[i].extend(vertex[index != NULL ? index[i * 3 + k] : i * 3 + k].position);
+		}
+
+		buildBvh(box, node, triangle, leafSize);
+
+		edge.resize(triangle.size() * 9);
+		for (std::size_t i = 0; i < triangle.size(); ++i)
+		{
+			const GLuint t(triangle[i]);
+			const GLfloat* const p0(vertex[index != NULL ? index[t * 3 + 0] : t * 3 + 0].position);
+			const GLfloat* const p1(vertex[index != NULL ? index[t * 3 + 1] : t * 3 + 1].position);
+			const GLfloat* const p2(vertex[index != NULL ? index[t * 3 + 2] : t * 3 + 2].position);
+			GLfloat* const e(&edge[i * 9]);
+			for (int k = 0; k < 3; ++k)
+			{
+				e[k] = p0[k];
+				e[3 + k] = p1[k] - p0[k];
+				e[6 + k] = p2[k] - p0[k];
+			}
+		}
+	}
+
+	/*
+	 * @brief 最も近い交点を求める (Möller–Trumbore)
+	 * @param origin:    モデル座標系の始点
+	 * @param direction: モデル座標系の方向 (正規化していなくてよい)
+	 * @param tmax:      これより遠い交点は無視する
+	 * @param hit:       交点
+	 * @return           tmax より近い交点があれば true
+	 */
+	bool intersect(const GLfloat* origin, const GLfloat* direction, GLfloat tmax, Hit& hit) const
+	{
+		if (node.empty()) return false;
+
+		const GLfloat inverse[] = { 1.f / direction[0], 1.f / direction[1], 1.f / direction[2] };
+		bool found(false);
+
+		GLuint stack[bvhStackSize];
+		int top(0);
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			const BvhNode& n(node[stack[--top]]);
+			if (n.box.intersect(origin, inverse, tmax) >= tmax) continue;
+
+			if (n.count > 0)
+			{
+				for (GLuint i = n.index; i < n.index + n.count; ++i)
+				{
+					const GLfloat* const e(&edge[i * 9]);
+					const GLfloat* const e1(e + 3);
+					const GLfloat* const e2(e + 6);
+
+					const GLfloat p[] =
+					{
+						direction[1] * e2[2] - direction[2] * e2[1],
+						direction[2] * e2[0] - direction[0] * e2[2],
+						direction[0] * e2[1] - direction[1] * e2[0]
+					};
+					const GLfloat det(e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2]);
+					if (det == 0.f) continue;
+
+					const GLfloat invdet(1.f / det);
+					const GLfloat s[] = { origin[0] - e[0], origin[1] - e[1], origin[2] - e[2] };
+					const GLfloat u((s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invdet);
+					if (u < 0.f || u > 1.f) continue;
+
+					const GLfloat q[] =
+					{
+						s[1] * e1[2] - s[2] * e1[1],
+						s[2] * e1[0] - s[0] * e1[2],
+						s[0] * e1[1] - s[1] * e1[0]
+					};
+					const GLfloat v((direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * invdet);
+					if (v < 0.f || u + v > 1.f) continue;
+
+					const GLfloat t((e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invdet);
+					if (t <= 0.f || t >= tmax) continue;
+
+					tmax = t;
+					hit.triangle = triangle[i];
+					hit.t = t;
+					hit.u = u;
+					hit.v = v;
+					found = true;
+				}
+				continue;
+			}
+
+			// 近い方の子を先に調べる
+			const GLuint left(static_cast<GLuint>(&n - node.data()) + 1), right(n.index);
+			const GLfloat tl(node[left].box.intersect(origin, inverse, tmax));
+			const GLfloat tr(node[right].box.intersect(origin, inverse, tmax));
+			if (tl <= tr)
+			{
+				if (tr < tmax) stack[top++] = right;
+				if (tl < tmax) stack[top++] = left;
+			}
+			else
+			{
+				if (tl < tmax) stack[top++] = left;
+				if (tr < tmax) stack[top++] = right;
+			}
+		}
+
+		return found;
+	}
+
+	const Aabb& getBounds() const
+	{
+		return node.front().box;
+	}
+
+	bool empty() const
+	{
+		return node.empty();
+	}
+
+	std::size_t getNodeCount() const
+	{
+		return node.size();
+	}
+};
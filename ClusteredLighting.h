@@ -0,0 +1,143 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "Matrix.h"
+#include "LightCluster.h"
+
+// クラスタに割り当てた光源をテクスチャバッファでシェーダに渡す
+// cluster.vert / cluster.frag と組み合わせて使う
+class ClusteredLighting
+{
+	LightCluster cluster;
+
+	// 0: 光源, 1: クラスタごとのリストの位置, 2: 光源の番号のリスト
+	GLuint buffer[3];
+	GLuint texture[3];
+
+	std::vector<GLfloat> lightData;
+
+	// 光源の割り当てに使うスレッドの数
+	unsigned int threads;
+
+	// シェーダに渡すビューポート (毎フレーム GL から読み出さない)
+	GLfloat viewport[4];
+
+public:
+	// x, y: 画面の分割数
+	// z: 奥行きの分割数
+	// threads: 光源の割り当てに使うスレッドの数 (0 ならハードウェアのスレッド数)
+	ClusteredLighting(GLuint x = 16, GLuint y = 9, GLuint z = 24, unsigned int threads = 0)
+	 : cluster(x, y, z),
+	   threads(threads)
+	{
+		static const GLenum format[] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+
+		glGenBuffers(3, buffer);
+		glGenTextures(3, texture);
+		for (int i = 0; i < 3; ++i)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, buffer[i]);
+			glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+			glBindTexture(GL_TEXTURE_BUFFER, texture[i]);
+			glTexBuffer(GL_TEXTURE_BUFFER, format[i], buffer[i]);
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+		// 大きさが変わるまでは作ったときのビューポートを使う
+		GLint v[4];
+		glGetIntegerv(GL_VIEWPORT, v);
+		setViewport(v[0], v[1], v[2], v[3]);
+	}
+
+	virtual ~ClusteredLighting()
+	{
+		glDeleteTextures(3, texture);
+		glDeleteBuffers(3, buffer);
+	}
+
+private:
+	ClusteredLighting(const ClusteredLighting &o);
+	ClusteredLighting &operator=(const ClusteredLighting &o);
+
+	static void upload(GLuint buffer, GLsizeiptr size, const GLvoid* data)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+
+		// 前のフレームの内容は捨てて新しい記憶領域に書き込む
+		glBufferData(GL_TEXTURE_BUFFER, size > 0 ? size : 16, NULL, GL_STREAM_DRAW);
+		if (size > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+	}
+
+public:
+	/*
+	 * @brief 光源をクラスタに割り当ててテクスチャバッファに転送する
+	 * @param lights:     光源
+	 * @param count:      光源の数
+	 * @param view:       ビュー変換行列
+	 * @param projection: 投影変換行列
+	 */
+	void update(const PointLight* lights, GLsizei count, const Matrix& view, const Matrix& projection)
+	{
+		cluster.setProjection(projection);
+		cluster.assign(lights, count, view, threads);
+
+		// 視点座標系の位置と半径、色の 2 テクセルずつ
+		lightData.resize(count * 8);
+		for (GLsizei n = 0; n < count; ++n)
+		{
+			const GLfloat p[] = { lights[n].position[0], lights[n].position[1], lights[n].position[2], 1.f };
+			GLfloat* const d(&lightData[n * 8]);
+			view.transform(p, d);
+			d[3] = lights[n].radius;
+			d[4] = lights[n].color[0];
+			d[5] = lights[n].color[1];
+			d[6] = lights[n].color[2];
+			d[7] = 0.f;
+		}
+
+		const std::vector<LightCluster::Range>& grid(cluster.getGrid());
+		const std::vector<GLuint>& index(cluster.getIndex());
+		upload(buffer[0], lightData.size() * sizeof(GLfloat), lightData.data());
+		upload(buffer[1], grid.size() * sizeof(LightCluster::Range), grid.data());
+		upload(buffer[2], index.size() * sizeof(GLuint), index.data());
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	/*
+	 * @brief フラグメントの位置からクラスタを求めるのに使うビューポートを設定する
+	 *        ウィンドウの大きさが変わって glViewport() を呼んだときに同じ値で呼ぶ
+	 */
+	void setViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		viewport[0] = static_cast<GLfloat>(x);
+		viewport[1] = static_cast<GLfloat>(y);
+		viewport[2] = static_cast<GLfloat>(width);
+		viewport[3] = static_cast<GLfloat>(height);
+	}
+
+	/*
+	 * @brief テクスチャを結合してシェーダの uniform 変数を設定する
+	 * @param program: cluster.frag を含むプログラムオブジェクト (使用中のもの)
+	 * @param unit:    最初に使うテクスチャユニット (3 つ使う)
+	 */
+	void use(GLuint program, GLint unit = 0) const
+	{
+		static const char* const name[] = { "lightData", "clusterGrid", "lightIndex" };
+
+		for (int i = 0; i < 3; ++i)
+		{
+			glActiveTexture(GL_TEXTURE0 + unit + i);
+			glBindTexture(GL_TEXTURE_BUFFER, texture[i]);
+			glUniform1i(glGetUniformLocation(program, name[i]), unit + i);
+		}
+		glActiveTexture(GL_TEXTURE0);
+
+		const GLuint* const dim(cluster.getDimension());
+		glUniform3ui(glGetUniformLocation(program, "clusterDim"), dim[0], dim[1], dim[2]);
+		glUniform4fv(glGetUniformLocation(program, "viewport"), 1, viewport);
+		glUniform2f(glGetUniformLocation(program, "depthRange"), cluster.getNear(), cluster.getFar());
+	}
+
+	const LightCluster& getCluster() const { return cluster; }
+};
@@ -0,0 +1,189 @@
+#pragma once
+#include <deque>
+#include <limits>
+#include <algorithm>
+
+// 画面の書き換えが必要かどうかと書き換える範囲を管理する
+// 時刻は引数で受け取るのでウィンドウがなくても使える
+class DamageTracker
+{
+public:
+	struct Stats
+	{
+		unsigned long drawn;   // 描画したフレーム数
+		unsigned long skipped; // 変化がなく描画しなかった回数
+		double latency;        // 入力から表示までの平均時間 (秒)
+		double maxLatency;     // 入力から表示までの最大時間 (秒)
+	};
+
+	// 書き換える範囲 (フレームバッファの画素単位、左下が原点)
+	struct Rect
+	{
+		int x, y, width, height;
+
+		bool empty() const
+		{
+			return width <= 0 || height <= 0;
+		}
+
+		// 画面全体を表す範囲
+		static Rect whole()
+		{
+			return Rect{ 0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max() };
+		}
+
+		bool full() const
+		{
+			return width == std::numeric_limits<int>::max();
+		}
+
+		void merge(const Rect& r)
+		{
+			if (r.empty()) return;
+			if (empty())
+			{
+				*this = r;
+				return;
+			}
+
+			const int x1(std::max(x + width, r.x + r.width)), y1(std::max(y + height, r.y + r.height));
+			x = std::min(x, r.x);
+			y = std::min(y, r.y);
+			width = x1 - x;
+			height = y1 - y;
+		}
+	};
+
+private:
+	bool dirty;        // 画面全体を書き換える
+	Rect damage;       // このフレームで書き換える範囲
+	double animateEnd; // この時刻まではアニメーションのために描画し続ける
+	double inputTime;  // 表示されていない最も古い入力の時刻 (なければ負)
+
+	// 直前のフレームの書き換え範囲
+	// バックバッファは入れ替わるので、その枚数分の範囲を合わせて書き換える
+	std::deque<Rect> history;
+	const std::size_t buffers;
+
+	Stats stats;
+	double latencySum;
+	unsigned long latencyCount;
+
+public:
+	// buffers: スワップで入れ替わるバッファの数
+	DamageTracker(std::size_t buffers = 2)
+	 : dirty(true),
+	   damage{ 0, 0, 0, 0 },
+	   animateEnd(-std::numeric_limits<double>::infinity()),
+	   inputTime(-1.0),
+	   buffers(buffers),
+	   stats(),
+	   latencySum(0.0),
+	   latencyCount(0)
+	{}
+
+	// 画面全体を書き換える
+	void invalidate()
+	{
+		dirty = true;
+	}
+
+	// 一部分を書き換える
+	void invalidate(int x, int y, int width, int height)
+	{
+		damage.merge(Rect{ x, y, width, height });
+	}
+
+	// 入力があったので画面全体を書き換える
+	void input(double now)
+	{
+		dirty = true;
+		if (inputTime < 0.0) inputTime = now;
+	}
+
+	// until の時刻までアニメーションのために描画し続ける (無限大で止めるまで)
+	void animate(double until)
+	{
+		animateEnd = std::max(animateEnd, until);
+	}
+
+	// アニメーションを止める
+	void stop()
+	{
+		animateEnd = -std::numeric_limits<double>::infinity();
+	}
+
+	bool animating(double now) const
+	{
+		return now < animateEnd;
+	}
+
+	// 描画が必要か
+	bool needsRedraw(double now) const
+	{
+		return dirty || !damage.empty() || animating(now);
+	}
+
+	/*
+	 * @brief イベントを待つ時間を求める
+	 * @param now:     現在時刻
+	 * @param maxWait: 待つ時間の上限
+	 * @return         描画が必要なら 0
+	 */
+	double timeout(double now, double maxWait) const
+	{
+		return needsRedraw(now) ? 0.0 : maxWait;
+	}
+
+	/*
+	 * @brief このフレームで書き換える範囲を求める
+	 * @param rect: 書き換える範囲
+	 * @return      一部分だけ書き換えればよければ true、画面全体なら false
+	 */
+	bool getDamage(Rect& rect, double now) const
+	{
+		if (dirty || animating(now) || damage.empty()) return false;
+
+		rect = damage;
+		for (const Rect& r : history)
+		{
+			if (r.full()) return false;
+			rect.merge(r);
+		}
+
+		return true;
+	}
+
+	// 描画しなかった
+	void skip()
+	{
+		++stats.skipped;
+	}
+
+	// 描画したフレームを表示した
+	void presented(double now)
+	{
+		if (inputTime >= 0.0)
+		{
+			const double latency(now - inputTime);
+			latencySum += latency;
+			++latencyCount;
+			stats.maxLatency = std::max(stats.maxLatency, latency);
+			stats.latency = latencySum / latencyCount;
+			inputTime = -1.0;
+		}
+
+		// 他のバックバッファはこのフレームの書き換えを反映していないので範囲を覚えておく
+		history.push_front(dirty || damage.empty() ? Rect::whole() : damage);
+		while (history.size() >= buffers) history.pop_back();
+
+		dirty = false;
+		damage = Rect{ 0, 0, 0, 0 };
+		++stats.drawn;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+};
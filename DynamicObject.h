@@ -0,0 +1,209 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "Object.h"
+#include "RingBuffer.h"
+
+// 毎フレーム内容を書き換える頂点バッファオブジェクト
+class DynamicObject
+{
+public:
+	// 書き込みの方式
+	enum Strategy
+	{
+		Orphan,         // 折り返すたびに glBufferData で古い記憶領域を手放す
+		Unsynchronized, // GL_MAP_UNSYNCHRONIZED_BIT でマップしフェンスで待つ
+		Persistent,     // glBufferStorage で確保して一度だけマップする
+		SubData         // CPU 側の一時領域に書いて glBufferSubData で写す (比較用)
+	};
+
+private:
+	GLuint vao;
+	GLuint vbo;
+	const Strategy strategy;
+	RingBuffer ring;
+	Object::Vertex* persistent;
+
+	// SubData で書き込む一時領域
+	std::vector<Object::Vertex> staging;
+
+	// 直前に書き込んだ範囲
+	GLint first;
+	GLsizei count;
+
+	// 統計
+	GLsizeiptr streamed;
+	GLuint stalls;
+
+public:
+	// size: 頂点の位置の次元
+	// vertexcount: 1 フレームに書き込む頂点の最大数
+	// frames: 同時に GPU が読んでいる可能性のあるフレーム数
+	// strategy: 書き込みの方式、Persistent は ARB_buffer_storage がなければ Unsynchronized になる
+	DynamicObject(
+		GLint size,
+		GLsizei vertexcount,
+		GLsizei frames = 3,
+		Strategy strategy = Persistent)
+	 : strategy(strategy == Persistent && !GLEW_ARB_buffer_storage ? Unsynchronized : strategy),
+	   ring(static_cast<GLsizeiptr>(vertexcount) * frames * sizeof(Object::Vertex)),
+	   persistent(NULL),
+	   first(0),
+	   count(0),
+	   streamed(0),
+	   stalls(0)
+	{
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+		if (this->strategy == Persistent)
+		{
+			const GLbitfield flags(GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+			glBufferStorage(GL_ARRAY_BUFFER, ring.getCapacity(), NULL, flags);
+			persistent = static_cast<Object::Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, ring.getCapacity(), flags));
+		}
+		else
+		{
+			glBufferData(GL_ARRAY_BUFFER, ring.getCapacity(), NULL, GL_STREAM_DRAW);
+		}
+
+		glVertexAttribPointer(0, size, GL_FLOAT, GL_FALSE, sizeof(Object::Vertex), static_cast<Object::Vertex*>(0)->position);
+		glEnableVertexAttribArray(0);
+
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Object::Vertex), static_cast<Object::Vertex*>(0)->normal);
+		glEnableVertexAttribArray(1);
+	}
+
+	virtual ~DynamicObject()
+	{
+		while (const RingBuffer::Frame* f = ring.oldest())
+		{
+			glDeleteSync(f->fence);
+			ring.retire();
+		}
+
+		if (persistent != NULL)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vbo);
+	}
+
+private:
+	DynamicObject(const DynamicObject &o);
+	DynamicObject &operator=(const DynamicObject &o);
+
+	// 最も古いフレームを GPU が読み終えるまで待って解放する
+	void wait()
+	{
+		const RingBuffer::Frame* const f(ring.oldest());
+		if (f == NULL) return;
+
+		if (f->fence != NULL)
+		{
+			if (glClientWaitSync(f->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			{
+				++stalls;
+				glClientWaitSync(f->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			}
+			glDeleteSync(f->fence);
+		}
+
+		ring.retire();
+	}
+
+public:
+	/*
+	 * @brief 頂点を書き込む領域をマップする
+	 * @param vertexcount: 書き込む頂点の数
+	 * @return             書き込み先、確保できなければ NULL
+	 */
+	Object::Vertex* map(GLsizei vertexcount)
+	{
+		const GLsizeiptr bytes(vertexcount * sizeof(Object::Vertex));
+		GLsizeiptr offset(ring.allocate(bytes, sizeof(Object::Vertex)));
+
+		if (strategy == Orphan)
+		{
+			// 空きがなくなったら記憶領域ごと取り替えて GPU を待たない
+			if (offset < 0)
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, vbo);
+				glBufferData(GL_ARRAY_BUFFER, ring.getCapacity(), NULL, GL_STREAM_DRAW);
+				ring.reset();
+				offset = ring.allocate(bytes, sizeof(Object::Vertex));
+			}
+		}
+		else
+		{
+			while (offset < 0 && ring.oldest() != NULL)
+			{
+				wait();
+				offset = ring.allocate(bytes, sizeof(Object::Vertex));
+			}
+		}
+		if (offset < 0) return NULL;
+
+		first = static_cast<GLint>(offset / sizeof(Object::Vertex));
+		count = vertexcount;
+		streamed += bytes;
+
+		if (persistent != NULL) return persistent + first;
+
+		if (strategy == SubData)
+		{
+			staging.resize(vertexcount);
+			return staging.data();
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		return static_cast<Object::Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	}
+
+	// 書き込みを終える
+	void unmap()
+	{
+		if (persistent != NULL) return;
+
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		if (strategy == SubData)
+			glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Object::Vertex), count * sizeof(Object::Vertex), staging.data());
+		else
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	// このフレームの描画命令を出した後に呼んで書き込んだ領域を閉じる
+	void fence()
+	{
+		ring.submit(strategy == Orphan ? NULL : glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	}
+
+	void bind() const
+	{
+		glBindVertexArray(vao);
+	}
+
+	// 直前に書き込んだ頂点を描画する
+	void draw(GLenum mode = GL_TRIANGLES) const
+	{
+		bind();
+		glDrawArrays(mode, first, count);
+	}
+
+	Strategy getStrategy() const { return strategy; }
+
+	// これまでに書き込んだバイト数
+	GLsizeiptr getStreamedBytes() const { return streamed; }
+
+	// GPU を待った回数
+	GLuint getStallCount() const { return stalls; }
+
+	const RingBuffer& getRing() const { return ring; }
+};
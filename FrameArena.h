@@ -0,0 +1,227 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// 1 フレームの間だけ使う一時データのための線形アロケータ
+// スレッドごとに local() で取り出し、確保は先頭から詰めるだけで個別には解放しない
+// Window::swapBuffers() で advance() するとフレームが進み、
+// frames フレーム前に確保した領域をまとめて再利用する
+// (確保したフレームから frames - 1 フレーム後まではワーカースレッドや転送から参照してよい)
+class FrameArena
+{
+public:
+	// 使い回す領域の数 (3 ならトリプルバッファ)
+	static const unsigned int frames = 3;
+
+	struct Stats
+	{
+		std::size_t used;        // このフレームで確保したバイト数
+		std::size_t highWater;   // 1 フレームで確保した最大のバイト数
+		std::size_t capacity;    // 今の領域の大きさ
+		std::size_t overflows;   // 領域が足りずに別に確保した回数
+		std::size_t allocations; // このフレームで確保した回数
+	};
+
+private:
+	struct Region
+	{
+		std::unique_ptr<char[]> memory;
+		std::size_t capacity;
+		std::size_t used;
+
+		// 足りなかった分を別に確保したもの
+		std::vector<std::unique_ptr<char[]>> overflow;
+		std::size_t overflowBytes;
+	};
+
+	Region region[frames];
+	unsigned int current;
+
+	// 最後に合わせたフレームの番号
+	unsigned long frame;
+
+	std::size_t highWater;
+	std::size_t overflows;
+	std::size_t allocations;
+
+	// 全スレッドに共通のフレームの番号
+	static std::atomic<unsigned long>& counter()
+	{
+		static std::atomic<unsigned long> c(0);
+		return c;
+	}
+
+public:
+	// capacity: 1 フレームあたりの領域の初期の大きさ (足りなければ次に使うときに広げる)
+	FrameArena(std::size_t capacity = 1 << 20)
+	 : current(0),
+	   frame(counter().load(std::memory_order_acquire)),
+	   highWater(0),
+	   overflows(0),
+	   allocations(0)
+	{
+		for (Region& r : region)
+		{
+			r.capacity = capacity;
+			r.used = 0;
+			r.overflowBytes = 0;
+			r.memory.reset(new char[capacity]);
+			poison(r, capacity);
+		}
+	}
+
+private:
+	FrameArena(const FrameArena &o);
+	FrameArena &operator=(const FrameArena &o);
+
+	// デバッグ時は再利用する領域を塗りつぶしてフレームを過ぎた参照を見つけやすくする
+	static void poison(Region& r, std::size_t size)
+	{
+#ifndef NDEBUG
+		memset(r.memory.get(), 0xdd, size);
+#endif
+	}
+
+	// 領域を空にする (足りなかったら広げる)
+	static void recycle(Region& r)
+	{
+		if (r.overflowBytes > 0)
+		{
+			r.capacity = std::max(r.capacity * 2, r.used + r.overflowBytes);
+			r.memory.reset(new char[r.capacity]);
+			r.used = r.capacity;
+		}
+		poison(r, r.used);
+
+		r.overflow.clear();
+		r.overflowBytes = 0;
+		r.used = 0;
+	}
+
+	// 進んだフレームの数だけ領域を切り替える
+	void sync()
+	{
+		const unsigned long now(counter().load(std::memory_order_acquire));
+		if (now == frame) return;
+
+		const unsigned long steps(std::min(now - frame, static_cast<unsigned long>(frames)));
+		for (unsigned long i = 0; i < steps; ++i)
+		{
+			current = (current + 1) % frames;
+			recycle(region[current]);
+		}
+
+		frame = now;
+		allocations = 0;
+	}
+
+public:
+	// このスレッドのアロケータ
+	static FrameArena& local()
+	{
+		thread_local FrameArena arena;
+		return arena;
+	}
+
+	// フレームを進める (Window::swapBuffers() から呼ぶ)
+	static void advance()
+	{
+		counter().fetch_add(1, std::memory_order_release);
+	}
+
+	/*
+	 * @brief 今のフレームの間だけ使う領域を確保する
+	 * @param size:      バイト数
+	 * @param alignment: 境界 (2 のべき乗)
+	 * @return           確保した領域
+	 */
+	void* allocate(std::size_t size, std::size_t alignment = 16)
+	{
+		sync();
+		++allocations;
+
+		Region& r(region[current]);
+		const std::uintptr_t base(reinterpret_cast<std::uintptr_t>(r.memory.get()));
+		const std::uintptr_t p((base + r.used + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1));
+
+		if (p + size <= base + r.capacity)
+		{
+			r.used = p + size - base;
+		}
+		else
+		{
+			// 領域が足りなければ別に確保して、次にこの領域を使うときに広げる
+			r.overflow.emplace_back(new char[size + alignment]);
+			r.overflowBytes += size + alignment;
+			++overflows;
+
+			const std::uintptr_t q(reinterpret_cast<std::uintptr_t>(r.overflow.back().get()));
+			highWater = std::max(highWater, r.used + r.overflowBytes);
+			return reinterpret_cast<void*>((q + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1));
+		}
+
+		highWater = std::max(highWater, r.used + r.overflowBytes);
+		return reinterpret_cast<void*>(p);
+	}
+
+	/*
+	 * @brief 今のフレームの間だけ使う配列を確保する
+	 *        デストラクタは呼ばないので後始末の要らない型に限る
+	 * @param count:     要素数
+	 * @param alignment: 境界 (SIMD で扱う Matrix の配列なら 16 以上)
+	 * @return           既定のコンストラクタで初期化した配列
+	 */
+	template <typename T>
+	T* allocateArray(std::size_t count, std::size_t alignment = std::max<std::size_t>(alignof(T), 16))
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "FrameArena does not run destructors");
+
+		T* const a(static_cast<T*>(allocate(count * sizeof(T), alignment)));
+		for (std::size_t i = 0; i < count; ++i) new(a + i) T;
+		return a;
+	}
+
+	Stats getStats()
+	{
+		sync();
+		const Region& r(region[current]);
+		return Stats{ r.used + r.overflowBytes, highWater, r.capacity, overflows, allocations };
+	}
+};
+
+// 標準ライブラリのコンテナで FrameArena を使うためのアロケータ
+// 解放は何もしないので、コンテナもそのフレームの間だけ使う
+template <typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator() {}
+
+	template <typename U>
+	FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(FrameArena::local().allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, std::size_t) {}
+
+	template <typename U>
+	bool operator==(const FrameAllocator<U>&) const { return true; }
+
+	template <typename U>
+	bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+// そのフレームの間だけ使う配列
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
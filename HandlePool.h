@@ -0,0 +1,134 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <GL/glew.h>
+
+// 世代付きのハンドル
+// 下位 20 bit が記憶領域の番号、上位 12 bit が世代で 0 は無効なハンドル
+template <typename T>
+struct Handle
+{
+	GLuint id;
+
+	Handle()
+	 : id(0)
+	{}
+
+	explicit Handle(GLuint id)
+	 : id(id)
+	{}
+
+	explicit operator bool() const
+	{
+		return id != 0;
+	}
+
+	bool operator==(const Handle& h) const { return id == h.id; }
+
+	bool operator!=(const Handle& h) const { return id != h.id; }
+};
+
+// 連続した記憶領域に値を置き、世代付きのハンドルで参照する
+// 解放した領域を再利用すると世代が進むので、古いハンドルは無効になる
+template <typename T>
+class HandlePool
+{
+public:
+	static const GLuint indexBits = 20;
+	static const GLuint indexMask = (1u << indexBits) - 1;
+	static const GLuint generationMask = (1u << (32 - indexBits)) - 1;
+
+private:
+	std::vector<T> data;
+	std::vector<GLuint> generation;
+
+	// 空いている領域 (先に空いたものから使って世代の一巡を遅らせる)
+	std::deque<GLuint> free;
+
+	std::size_t live;
+
+public:
+	HandlePool()
+	 : live(0)
+	{}
+
+	/*
+	 * @brief 値を格納してハンドルを返す
+	 * @param value: 格納する値
+	 * @return       ハンドル (領域が足りなければ無効なハンドル)
+	 */
+	Handle<T> create(const T& value)
+	{
+		GLuint index;
+		if (!free.empty())
+		{
+			index = free.front();
+			free.pop_front();
+			data[index] = value;
+		}
+		else
+		{
+			if (data.size() > indexMask) return Handle<T>();
+			index = static_cast<GLuint>(data.size());
+			data.push_back(value);
+			generation.push_back(1);
+		}
+
+		++live;
+		return Handle<T>(generation[index] << indexBits | index);
+	}
+
+	// ハンドルが今も有効か
+	bool valid(Handle<T> h) const
+	{
+		const GLuint index(h.id & indexMask);
+		return h.id != 0 && index < generation.size() && generation[index] == h.id >> indexBits;
+	}
+
+	// ハンドルの指す値 (無効なハンドルなら NULL)
+	T* get(Handle<T> h)
+	{
+		return valid(h) ? &data[h.id & indexMask] : NULL;
+	}
+
+	const T* get(Handle<T> h) const
+	{
+		return valid(h) ? &data[h.id & indexMask] : NULL;
+	}
+
+	/*
+	 * @brief ハンドルの指す領域を解放する
+	 * @param h: 解放するハンドル
+	 * @return   無効なハンドルなら false
+	 */
+	bool destroy(Handle<T> h)
+	{
+		if (!valid(h)) return false;
+
+		// 世代を進めて 0 は飛ばす
+		const GLuint index(h.id & indexMask);
+		generation[index] = (generation[index] + 1) & generationMask;
+		if (generation[index] == 0) generation[index] = 1;
+
+		free.push_back(index);
+		--live;
+		return true;
+	}
+
+	// 有効な値を順に処理する
+	template <typename Func>
+	void forEach(Func func)
+	{
+		std::vector<bool> unused(data.size(), false);
+		for (GLuint index : free) unused[index] = true;
+
+		for (std::size_t index = 0; index < data.size(); ++index)
+			if (!unused[index]) func(data[index]);
+	}
+
+	// 有効な値の数
+	std::size_t size() const { return live; }
+
+	// 確保した領域の数
+	std::size_t capacity() const { return data.size(); }
+};
@@ -0,0 +1,348 @@
+#pragma once
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <GL/glew.h>
+#include "Matrix.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// 点光源
+struct PointLight
+{
+	GLfloat position[3]; // ワールド座標系の位置
+	GLfloat radius;      // 影響の及ぶ半径
+	GLfloat color[3];    // 拡散反射光強度
+	GLfloat pad;
+};
+
+// 視錐台を格子 (クラスタ) に分割して各クラスタに届く光源を求める
+// GL は呼ばないので光源の割り当てだけを単独で使える
+class LightCluster
+{
+public:
+	// クラスタごとの光源の番号のリストの位置
+	struct Range
+	{
+		GLuint offset;
+		GLuint count;
+	};
+
+private:
+	const GLuint dim[3];  // x, y, z 方向の分割数
+	const GLuint stride;  // 1 スライスあたりのクラスタ数 (4 の倍数に切り上げ)
+	GLfloat zNear, zFar;
+
+	// 視点座標系のクラスタの境界ボックス (SoA)
+	std::vector<GLfloat> lo[3], hi[3];
+
+	// 視点座標系の光源 (x, y, z, 半径)
+	std::vector<GLfloat> light;
+
+	std::vector<Range> grid;
+	std::vector<GLuint> index;
+
+	// 割り当てを手伝うワーカースレッド
+	// 初めて複数のスレッドで assign() したときに作り、以後の呼び出しで使い回す
+	std::vector<std::thread> workers;
+	std::vector<std::vector<GLuint>> part; // スレッドごとの光源の番号のリスト
+	std::mutex mutex;
+	std::condition_variable start, done;
+	unsigned long generation; // assign() の回数
+	unsigned int active;      // 今回の割り当てに使うスレッドの数
+	unsigned int running;     // 割り当て中のワーカースレッドの数
+	bool quit;
+
+public:
+	// x, y: 画面の分割数
+	// z: 奥行きの分割数
+	LightCluster(GLuint x = 16, GLuint y = 9, GLuint z = 24)
+	 : dim{ x, y, z },
+	   stride((x * y + 3) & ~3u),
+	   zNear(1.f),
+	   zFar(10.f),
+	   grid(x * y * z),
+	   part(1),
+	   generation(0),
+	   active(1),
+	   running(0),
+	   quit(false)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			lo[k].assign(stride * z, 0.f);
+			hi[k].assign(stride * z, 0.f);
+		}
+	}
+
+	virtual ~LightCluster()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		start.notify_all();
+
+		for (std::thread& t : workers) t.join();
+	}
+
+private:
+	LightCluster(const LightCluster &o);
+	LightCluster &operator=(const LightCluster &o);
+
+	// t 番目のワーカースレッド (seen は作ったときの assign() の回数)
+	void work(unsigned int t, unsigned long seen)
+	{
+		for (;;)
+		{
+			unsigned int n;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				start.wait(lock, [this, seen] { return quit || generation != seen; });
+				if (quit) return;
+
+				seen = generation;
+				n = active;
+			}
+
+			// 今回使わないスレッドは次の呼び出しを待つ
+			if (t >= n) continue;
+
+			assignSlices(dim[2] * t / n, dim[2] * (t + 1) / n, part[t]);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--running;
+			}
+			done.notify_one();
+		}
+	}
+
+public:
+
+	/*
+	 * @brief 投影変換行列からクラスタの境界ボックスを求める
+	 * @param projection: Matrix::perspective() で作った投影変換行列
+	 */
+	void setProjection(const Matrix& projection)
+	{
+		zNear = projection[14] / (projection[10] - 1.f);
+		zFar = projection[14] / (projection[10] + 1.f);
+
+		for (GLuint k = 0; k < dim[2]; ++k)
+		{
+			const GLfloat d[] = { depth(k), depth(k + 1) };
+
+			for (GLuint j = 0; j < dim[1]; ++j)
+			{
+				const GLfloat ny[] = { 2.f * j / dim[1] - 1.f, 2.f * (j + 1) / dim[1] - 1.f };
+
+				for (GLuint i = 0; i < dim[0]; ++i)
+				{
+					const GLfloat nx[] = { 2.f * i / dim[0] - 1.f, 2.f * (i + 1) / dim[0] - 1.f };
+					const GLuint c(k * stride + j * dim[0] + i);
+
+					// 2 つの奥行きでのタイルの四隅を囲む
+					lo[0][c] = lo[1][c] = lo[2][c] = HUGE_VALF;
+					hi[0][c] = hi[1][c] = hi[2][c] = -HUGE_VALF;
+					for (int a = 0; a < 8; ++a)
+					{
+						const GLfloat z(d[a >> 2 & 1]);
+						const GLfloat p[] = { nx[a & 1] * z / projection[0], ny[a >> 1 & 1] * z / projection[5], -z };
+						for (int e = 0; e < 3; ++e)
+						{
+							lo[e][c] = std::min(lo[e][c], p[e]);
+							hi[e][c] = std::max(hi[e][c], p[e]);
+						}
+					}
+				}
+			}
+
+			// 余りは何とも交わらないようにする
+			for (GLuint c = k * stride + dim[0] * dim[1]; c < (k + 1) * stride; ++c)
+			{
+				for (int e = 0; e < 3; ++e)
+				{
+					lo[e][c] = HUGE_VALF;
+					hi[e][c] = -HUGE_VALF;
+				}
+			}
+		}
+	}
+
+	// スライス k の手前の距離 (奥行きを指数的に分割する)
+	GLfloat depth(GLuint k) const
+	{
+		return zNear * pow(zFar / zNear, static_cast<GLfloat>(k) / dim[2]);
+	}
+
+	/*
+	 * @brief 光源をクラスタに割り当てる
+	 * @param lights:  光源
+	 * @param count:   光源の数
+	 * @param view:    ビュー変換行列
+	 * @param threads: 使うスレッドの数 (0 ならハードウェアのスレッド数)
+	 *                 1 なら呼び出したスレッドだけで割り当て、2 以上ならワーカースレッドを使い回す
+	 */
+	void assign(const PointLight* lights, GLsizei count, const Matrix& view, unsigned int threads = 1)
+	{
+		light.resize(count * 4);
+		for (GLsizei n = 0; n < count; ++n)
+		{
+			const GLfloat p[] = { lights[n].position[0], lights[n].position[1], lights[n].position[2], 1.f };
+			view.transform(p, &light[n * 4]);
+			light[n * 4 + 3] = lights[n].radius;
+		}
+
+		if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+		threads = std::max(std::min(threads, dim[2]), 1u);
+
+		// スライスを分けて並列に割り当てる
+		if (threads > 1)
+		{
+			if (part.size() < threads) part.resize(threads);
+			while (workers.size() + 1 < threads)
+				workers.emplace_back(&LightCluster::work, this, static_cast<unsigned int>(workers.size() + 1), generation);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				active = threads;
+				running = threads - 1;
+				++generation;
+			}
+			start.notify_all();
+		}
+
+		assignSlices(0, dim[2] / threads, part[0]);
+
+		if (threads > 1)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this] { return running == 0; });
+		}
+
+		// スライスごとのリストをつなげる
+		index.clear();
+		for (unsigned int t = 0; t < threads; ++t)
+		{
+			const GLuint base(static_cast<GLuint>(index.size()));
+			const GLuint z0(dim[2] * t / threads), z1(dim[2] * (t + 1) / threads);
+			for (GLuint c = z0 * dim[0] * dim[1]; c < z1 * dim[0] * dim[1]; ++c) grid[c].offset += base;
+			index.insert(index.end(), part[t].begin(), part[t].end());
+		}
+	}
+
+private:
+	// スライス z0 から z1 の手前までのクラスタに光源を割り当てる
+	void assignSlices(GLuint z0, GLuint z1, std::vector<GLuint>& list)
+	{
+		const GLsizei count(static_cast<GLsizei>(light.size() / 4));
+		const GLuint tiles(dim[0] * dim[1]);
+		std::vector<std::vector<GLuint>> cluster(stride);
+		list.clear();
+
+		for (GLuint k = z0; k < z1; ++k)
+		{
+			const GLfloat d0(depth(k)), d1(depth(k + 1));
+			for (std::vector<GLuint>& c : cluster) c.clear();
+
+			for (GLsizei n = 0; n < count; ++n)
+			{
+				const GLfloat* const l(&light[n * 4]);
+
+				// スライスの奥行きの範囲と交わらなければ調べない
+				if (-l[2] + l[3] < d0 || -l[2] - l[3] > d1) continue;
+
+				const GLuint base(k * stride);
+				GLuint c(0);
+
+#if defined(__SSE2__) || defined(_M_X64)
+				// 光源の球と 4 つのクラスタの境界ボックスをまとめて調べる
+				const __m128 zero(_mm_setzero_ps());
+				const __m128 cx(_mm_set1_ps(l[0])), cy(_mm_set1_ps(l[1])), cz(_mm_set1_ps(l[2]));
+				const __m128 r2(_mm_set1_ps(l[3] * l[3]));
+				for (; c < stride; c += 4)
+				{
+					const __m128 dx(_mm_add_ps(
+						_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&lo[0][base + c]), cx), zero),
+						_mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(&hi[0][base + c])), zero)));
+					const __m128 dy(_mm_add_ps(
+						_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&lo[1][base + c]), cy), zero),
+						_mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(&hi[1][base + c])), zero)));
+					const __m128 dz(_mm_add_ps(
+						_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&lo[2][base + c]), cz), zero),
+						_mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(&hi[2][base + c])), zero)));
+					const __m128 d2(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+					int mask(_mm_movemask_ps(_mm_cmple_ps(d2, r2)));
+					while (mask != 0)
+					{
+						const int b(mask & -mask);
+						const GLuint e(c + (b == 1 ? 0 : b == 2 ? 1 : b == 4 ? 2 : 3));
+						if (e < tiles) cluster[e].push_back(static_cast<GLuint>(n));
+						mask &= mask - 1;
+					}
+				}
+#endif
+				for (; c < tiles; ++c)
+				{
+					GLfloat d2(0.f);
+					for (int e = 0; e < 3; ++e)
+					{
+						const GLfloat v(std::max(std::max(lo[e][base + c] - l[e], l[e] - hi[e][base + c]), 0.f));
+						d2 += v * v;
+					}
+					if (d2 <= l[3] * l[3]) cluster[c].push_back(static_cast<GLuint>(n));
+				}
+			}
+
+			for (GLuint c = 0; c < tiles; ++c)
+			{
+				grid[k * tiles + c] = Range{ static_cast<GLuint>(list.size()), static_cast<GLuint>(cluster[c].size()) };
+				list.insert(list.end(), cluster[c].begin(), cluster[c].end());
+			}
+		}
+	}
+
+public:
+	// 視点座標系の位置 p を含むクラスタの番号 (視錐台の外なら -1)
+	GLint locate(const GLfloat* p, const Matrix& projection) const
+	{
+		const GLfloat d(-p[2]);
+		if (d < zNear || d >= zFar) return -1;
+
+		const GLfloat nx(p[0] * projection[0] / d), ny(p[1] * projection[5] / d);
+		if (nx < -1.f || nx >= 1.f || ny < -1.f || ny >= 1.f) return -1;
+
+		const GLuint i(static_cast<GLuint>((nx + 1.f) * 0.5f * dim[0]));
+		const GLuint j(static_cast<GLuint>((ny + 1.f) * 0.5f * dim[1]));
+		const GLuint k(std::min(dim[2] - 1, static_cast<GLuint>(log(d / zNear) / log(zFar / zNear) * dim[2])));
+
+		return static_cast<GLint>((k * dim[1] + j) * dim[0] + i);
+	}
+
+	const GLuint* getDimension() const { return dim; }
+
+	GLfloat getNear() const { return zNear; }
+
+	GLfloat getFar() const { return zFar; }
+
+	const std::vector<Range>& getGrid() const { return grid; }
+
+	const std::vector<GLuint>& getIndex() const { return index; }
+
+	// クラスタ c の境界ボックス
+	void getBounds(GLuint c, GLfloat* l, GLfloat* h) const
+	{
+		const GLuint tiles(dim[0] * dim[1]);
+		const GLuint s((c / tiles) * stride + c % tiles);
+		for (int e = 0; e < 3; ++e)
+		{
+			l[e] = lo[e][s];
+			h[e] = hi[e][s];
+		}
+	}
+};
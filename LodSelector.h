@@ -0,0 +1,70 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include "Matrix.h"
+#include "SolidShapeLod.h"
+
+// 描画するインスタンスごとに持たせて LOD の段を選ぶ
+class LodSelector
+{
+	GLsizei level;
+
+public:
+	LodSelector()
+	 : level(0)
+	{}
+
+	/*
+	 * @brief 包含球の画面上の大きさから LOD の段を選ぶ
+	 * @param shape:      LOD を持つ形状
+	 * @param projection: 投影変換行列
+	 * @param modelview:  モデルビュー変換行列
+	 * @param height:     ビューポートの高さ (画素)
+	 * @param threshold:  許容する画面上の誤差 (画素)
+	 * @param hysteresis: 粗い段に切り替えるときに誤差を余分に見込む割合
+	 * @return            選んだ段
+	 */
+	GLsizei select(
+		const SolidShapeLod& shape,
+		const Matrix& projection,
+		const Matrix& modelview,
+		GLfloat height,
+		GLfloat threshold = 1.f,
+		GLfloat hysteresis = 0.25f)
+	{
+		const GLfloat* const c(shape.getCenter());
+		const GLfloat z(modelview[2] * c[0] + modelview[6] * c[1] + modelview[10] * c[2] + modelview[14]);
+
+		// モデルビュー変換の拡大率
+		GLfloat scale(0.f);
+		for (int i = 0; i < 12; i += 4)
+			scale = std::max(scale, modelview[i] * modelview[i] + modelview[i + 1] * modelview[i + 1] + modelview[i + 2] * modelview[i + 2]);
+		scale = sqrt(scale);
+
+		// 視点が包含球の中にあれば最も細かい段にする
+		const GLfloat distance(-z);
+		if (distance <= shape.getRadius() * scale)
+			return level = 0;
+
+		// モデル座標系の長さ 1 が画面上で何画素になるか
+		const GLfloat pixels(scale * projection[5] * height * 0.5f / distance);
+
+		GLsizei fine(0), coarse(0);
+		for (GLsizei i = 1; i < shape.getLevelCount(); ++i)
+		{
+			// Level::error は元の頂点から面までの実測の最大距離なので画素に換算してそのまま比べられる
+			const GLfloat error(shape.getLevel(i).error * pixels);
+			if (error <= threshold) fine = i;
+			if (error <= threshold * (1.f - hysteresis)) coarse = i;
+		}
+
+		// 誤差が許容値を超えたらすぐに細かくし、十分に余裕があるときだけ粗くする
+		if (level > fine) level = fine;
+		else if (level < coarse) level = coarse;
+
+		return level;
+	}
+
+	GLsizei getLevel() const { return level; }
+
+};
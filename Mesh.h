@@ -0,0 +1,221 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "Object.h"
+#include "MeshCodec.h"
+
+// ファイルから読み込んだ形状データ
+struct Mesh
+{
+	GLint size;
+	std::vector<Object::Vertex> vertex;
+	std::vector<GLuint> index;
+};
+
+// 形状ファイルのヘッダ
+struct MeshHeader
+{
+	char magic[4];       // "MESH" (圧縮したものは "MSHZ")
+	GLint size;          // 頂点の位置の次元
+	GLsizei vertexcount; // 頂点の数
+	GLsizei indexcount;  // インデックスの要素数
+};
+
+// 圧縮した形状ファイルで MeshHeader に続くヘッダ
+// 頂点は 16 bit に量子化し、頂点とインデックスをそれぞれ差分の可変長符号にする
+struct MeshCodecHeader
+{
+	GLfloat offset[3];  // 位置の最小値
+	GLfloat scale[3];   // 位置の量子化の刻み
+	GLuint vertexBytes; // 頂点の符号のバイト数
+	GLuint indexBytes;  // インデックスの符号のバイト数
+};
+
+/*
+ * @brief 形状ファイルを読み込む
+ * @param name: ファイル名
+ * @param mesh: 読み込んだ形状データ
+ * @return      読み込みに成功すれば true
+ */
+inline bool readMesh(const char* name, Mesh& mesh)
+{
+	if (name == NULL) return false;
+
+	std::ifstream file(name, std::ios::binary);
+	if (file.fail())
+	{
+		std::cerr << "Error: Can't open mesh file: " << name << std::endl;
+		return false;
+	}
+
+	MeshHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof header);
+	const std::string magic(header.magic, 4);
+	if (file.fail() || (magic != "MESH" && magic != "MSHZ")
+		|| header.size < 1 || header.size > 4
+		|| header.vertexcount < 0 || header.indexcount < 0)
+	{
+		std::cerr << "Error: Invalid mesh file: " << name << std::endl;
+		return false;
+	}
+
+	// ヘッダに続くデータの大きさ
+	const std::streamoff start(file.tellg());
+	file.seekg(0, std::ios::end);
+	const std::size_t remaining(static_cast<std::size_t>(file.tellg() - start));
+	file.seekg(start);
+
+	mesh.size = header.size;
+
+	if (magic == "MESH")
+	{
+		// 壊れた要素数で巨大な領域を確保しないようにファイルの大きさと比べる
+		if (static_cast<std::size_t>(header.vertexcount) * sizeof(Object::Vertex)
+			+ static_cast<std::size_t>(header.indexcount) * sizeof(GLuint) > remaining)
+		{
+			std::cerr << "Error: Invalid mesh file: " << name << std::endl;
+			return false;
+		}
+
+		mesh.vertex.resize(header.vertexcount);
+		mesh.index.resize(header.indexcount);
+		file.read(reinterpret_cast<char*>(mesh.vertex.data()), header.vertexcount * sizeof(Object::Vertex));
+		file.read(reinterpret_cast<char*>(mesh.index.data()), header.indexcount * sizeof(GLuint));
+	}
+	else
+	{
+		MeshCodecHeader codec;
+		file.read(reinterpret_cast<char*>(&codec), sizeof codec);
+
+		// 符号の大きさをファイルの大きさと、要素数を符号の大きさと比べてから確保する
+		// (1 つの値の符号は少なくとも 1 バイト)
+		const std::size_t vertexBytes(codec.vertexBytes), indexBytes(codec.indexBytes);
+		if (file.fail() || vertexBytes + indexBytes > remaining - sizeof codec
+			|| static_cast<std::size_t>(header.vertexcount) * 6 > vertexBytes
+			|| static_cast<std::size_t>(header.indexcount) > indexBytes)
+		{
+			std::cerr << "Error: Invalid mesh file: " << name << std::endl;
+			return false;
+		}
+
+		mesh.vertex.resize(header.vertexcount);
+		mesh.index.resize(header.indexcount);
+
+		std::vector<GLubyte> code(vertexBytes + indexBytes);
+		file.read(reinterpret_cast<char*>(code.data()), code.size());
+
+		std::vector<GLuint> stream(static_cast<std::size_t>(header.vertexcount) * 6);
+		if (!file.fail()
+			&& decodeDelta(code.data(), codec.vertexBytes, stream.data(), stream.size()) == codec.vertexBytes
+			&& decodeDelta(code.data() + codec.vertexBytes, codec.indexBytes, mesh.index.data(), mesh.index.size()) == codec.indexBytes)
+		{
+			dequantizeVertex(stream.data(), header.vertexcount, codec.offset, codec.scale, mesh.vertex.data());
+		}
+		else
+		{
+			std::cerr << "Error: Invalid mesh file: " << name << std::endl;
+			return false;
+		}
+	}
+
+	if (file.fail())
+	{
+		std::cerr << "Error: Could not read mesh file: " << name << std::endl;
+		return false;
+	}
+
+	// 範囲外のインデックスは描画で GPU が頂点バッファの外を読むので受け付けない
+	if (!Object::checkIndex(header.vertexcount, header.indexcount, mesh.index.data()))
+	{
+		std::cerr << "Error: Index out of range in mesh file: " << name << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * @brief 形状ファイルを書き出す
+ * @param name: ファイル名
+ * @param mesh: 書き出す形状データ
+ * @return      書き出しに成功すれば true
+ */
+inline bool writeMesh(const char* name, const Mesh& mesh)
+{
+	std::ofstream file(name, std::ios::binary);
+	if (file.fail())
+	{
+		std::cerr << "Error: Can't open mesh file: " << name << std::endl;
+		return false;
+	}
+
+	const MeshHeader header =
+	{
+		{ 'M', 'E', 'S', 'H' },
+		mesh.size,
+		static_cast<GLsizei>(mesh.vertex.size()),
+		static_cast<GLsizei>(mesh.index.size())
+	};
+	file.write(reinterpret_cast<const char*>(&header), sizeof header);
+	file.write(reinterpret_cast<const char*>(mesh.vertex.data()), mesh.vertex.size() * sizeof(Object::Vertex));
+	file.write(reinterpret_cast<const char*>(mesh.index.data()), mesh.index.size() * sizeof(GLuint));
+
+	if (file.fail())
+	{
+		std::cerr << "Error: Could not write mesh file: " << name << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * @brief 形状ファイルを圧縮して書き出す
+ *        頂点の位置と法線は 16 bit に量子化する (インデックスは損失なし)
+ * @param name: ファイル名
+ * @param mesh: 書き出す形状データ
+ * @return      書き出しに成功すれば true
+ */
+inline bool writeCompressedMesh(const char* name, const Mesh& mesh)
+{
+	std::ofstream file(name, std::ios::binary);
+	if (file.fail())
+	{
+		std::cerr << "Error: Can't open mesh file: " << name << std::endl;
+		return false;
+	}
+
+	const GLsizei vertexcount(static_cast<GLsizei>(mesh.vertex.size()));
+	const MeshHeader header =
+	{
+		{ 'M', 'S', 'H', 'Z' },
+		mesh.size,
+		vertexcount,
+		static_cast<GLsizei>(mesh.index.size())
+	};
+
+	MeshCodecHeader codec;
+	std::vector<GLuint> stream;
+	quantizeVertex(mesh.vertex.data(), vertexcount, codec.offset, codec.scale, stream);
+
+	std::vector<GLubyte> code;
+	encodeDelta(stream.data(), stream.size(), code);
+	codec.vertexBytes = static_cast<GLuint>(code.size());
+	encodeDelta(mesh.index.data(), mesh.index.size(), code);
+	codec.indexBytes = static_cast<GLuint>(code.size()) - codec.vertexBytes;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof header);
+	file.write(reinterpret_cast<const char*>(&codec), sizeof codec);
+	file.write(reinterpret_cast<const char*>(code.data()), code.size());
+
+	if (file.fail())
+	{
+		std::cerr << "Error: Could not write mesh file: " << name << std::endl;
+		return false;
+	}
+
+	return true;
+}
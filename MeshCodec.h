@@ -0,0 +1,187 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <GL/glew.h>
+#include "Object.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// 前の値との差をジグザグ符号化して可変長 (7 bit ずつ) で詰める
+// インデックスと量子化した頂点の並びをどちらも損失なく圧縮する
+
+// 符号付きの差を小さな符号なし整数にする (0, -1, 1, -2, ... → 0, 1, 2, 3, ...)
+inline GLuint zigzagEncode(GLint v)
+{
+	return (static_cast<GLuint>(v) << 1) ^ static_cast<GLuint>(v >> 31);
+}
+
+inline GLint zigzagDecode(GLuint u)
+{
+	return static_cast<GLint>(u >> 1) ^ -static_cast<GLint>(u & 1);
+}
+
+/*
+ * @brief 値の並びを差分の可変長符号にして追加する
+ * @param value: 値の並び
+ * @param count: 値の数
+ * @param out:   符号を追加する先
+ */
+inline void encodeDelta(const GLuint* value, std::size_t count, std::vector<GLubyte>& out)
+{
+	GLuint prev(0);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		GLuint u(zigzagEncode(static_cast<GLint>(value[i] - prev)));
+		prev = value[i];
+
+		while (u >= 0x80)
+		{
+			out.push_back(static_cast<GLubyte>(u | 0x80));
+			u >>= 7;
+		}
+		out.push_back(static_cast<GLubyte>(u));
+	}
+}
+
+/*
+ * @brief 差分の可変長符号を値の並びに戻す
+ * @param in:    符号
+ * @param size:  符号のバイト数
+ * @param value: 戻した値の並び
+ * @param count: 値の数
+ * @return       読んだバイト数 (符号が壊れていれば 0)
+ */
+inline std::size_t decodeDelta(const GLubyte* in, std::size_t size, GLuint* value, std::size_t count)
+{
+	const GLubyte* p(in);
+	const GLubyte* const end(in + size);
+	GLuint prev(0);
+	std::size_t i(0);
+
+	while (i < count)
+	{
+		// 続けて 1 値ずつ戻す数
+		std::size_t n(count - i);
+
+#if defined(__SSE2__) || defined(_M_X64)
+		if (i + 16 <= count && p + 16 <= end)
+		{
+			const __m128i b(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+			if (_mm_movemask_epi8(b) == 0)
+			{
+				// 続く 16 バイトが全て 1 バイトの符号なら 16 個まとめて戻す
+				const __m128i half(_mm_and_si128(_mm_srli_epi16(b, 1), _mm_set1_epi8(0x7f)));
+				const __m128i sign(_mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(b, _mm_set1_epi8(1))));
+				const __m128i d8(_mm_xor_si128(half, sign));
+
+				// 32 bit に符号拡張する
+				const __m128i lo16(_mm_srai_epi16(_mm_unpacklo_epi8(d8, d8), 8));
+				const __m128i hi16(_mm_srai_epi16(_mm_unpackhi_epi8(d8, d8), 8));
+				const __m128i d[] =
+				{
+					_mm_srai_epi32(_mm_unpacklo_epi16(lo16, lo16), 16),
+					_mm_srai_epi32(_mm_unpackhi_epi16(lo16, lo16), 16),
+					_mm_srai_epi32(_mm_unpacklo_epi16(hi16, hi16), 16),
+					_mm_srai_epi32(_mm_unpackhi_epi16(hi16, hi16), 16)
+				};
+
+				// 4 つずつ累積和をとって前の値を足す
+				__m128i base(_mm_set1_epi32(static_cast<int>(prev)));
+				for (int k = 0; k < 4; ++k)
+				{
+					__m128i s(_mm_add_epi32(d[k], _mm_slli_si128(d[k], 4)));
+					s = _mm_add_epi32(s, _mm_slli_si128(s, 8));
+					s = _mm_add_epi32(s, base);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(value + i + k * 4), s);
+					base = _mm_shuffle_epi32(s, _MM_SHUFFLE(3, 3, 3, 3));
+				}
+
+				prev = value[i + 15];
+				p += 16;
+				i += 16;
+				continue;
+			}
+
+			// 長い符号が混じっていれば 16 個は 1 値ずつ戻してから次を調べる
+			n = 16;
+		}
+#endif
+		for (const std::size_t last(i + n); i < last; ++i)
+		{
+			GLuint u(0);
+			for (int shift = 0;; shift += 7)
+			{
+				if (p == end || shift > 28) return 0;
+
+				const GLubyte c(*p++);
+				u |= static_cast<GLuint>(c & 0x7f) << shift;
+				if (c < 0x80) break;
+			}
+
+			prev += static_cast<GLuint>(zigzagDecode(u));
+			value[i] = prev;
+		}
+	}
+
+	return static_cast<std::size_t>(p - in);
+}
+
+/*
+ * @brief 頂点の位置と法線を 16 bit に量子化して成分ごとに並べる
+ * @param vertex:      頂点属性を格納した配列
+ * @param vertexcount: 頂点の数
+ * @param offset:      位置の最小値
+ * @param scale:       位置の量子化の刻み
+ * @param stream:      成分ごとの量子化した値 (x, y, z, nx, ny, nz の順に vertexcount 個ずつ)
+ */
+inline void quantizeVertex(const Object::Vertex* vertex, GLsizei vertexcount,
+	GLfloat* offset, GLfloat* scale, std::vector<GLuint>& stream)
+{
+	for (int k = 0; k < 3; ++k)
+	{
+		GLfloat lo(vertexcount > 0 ? vertex[0].position[k] : 0.f), hi(lo);
+		for (GLsizei i = 1; i < vertexcount; ++i)
+		{
+			lo = std::min(lo, vertex[i].position[k]);
+			hi = std::max(hi, vertex[i].position[k]);
+		}
+		offset[k] = lo;
+		scale[k] = hi > lo ? (hi - lo) / 65535.f : 1.f;
+	}
+
+	stream.resize(vertexcount * 6);
+	for (GLsizei i = 0; i < vertexcount; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			const GLfloat q((vertex[i].position[k] - offset[k]) / scale[k]);
+			stream[k * vertexcount + i] = static_cast<GLuint>(std::min(std::max(q + 0.5f, 0.f), 65535.f));
+
+			const GLfloat n((vertex[i].normal[k] + 1.f) * 32767.5f);
+			stream[(k + 3) * vertexcount + i] = static_cast<GLuint>(std::min(std::max(n + 0.5f, 0.f), 65535.f));
+		}
+	}
+}
+
+/*
+ * @brief 量子化した値を頂点属性に戻す
+ * @param stream:      成分ごとの量子化した値
+ * @param vertexcount: 頂点の数
+ * @param offset:      位置の最小値
+ * @param scale:       位置の量子化の刻み
+ * @param vertex:      戻した頂点属性
+ */
+inline void dequantizeVertex(const GLuint* stream, GLsizei vertexcount,
+	const GLfloat* offset, const GLfloat* scale, Object::Vertex* vertex)
+{
+	for (GLsizei i = 0; i < vertexcount; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			vertex[i].position[k] = offset[k] + static_cast<GLfloat>(stream[k * vertexcount + i]) * scale[k];
+			vertex[i].normal[k] = static_cast<GLfloat>(stream[(k + 3) * vertexcount + i]) / 32767.5f - 1.f;
+		}
+	}
+}
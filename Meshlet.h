@@ -0,0 +1,309 @@
+#pragma once
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <GL/glew.h>
+#include "Object.h"
+#include "Matrix.h"
+
+// 三角形の小さなまとまり
+// インデックスバッファ内の連続した範囲で、包含球と法線の円錐で見えないものを間引く
+struct Meshlet
+{
+	GLuint first;      // インデックスバッファ内の先頭位置
+	GLuint count;      // インデックスの要素数
+	GLfloat center[3]; // 包含球の中心
+	GLfloat radius;    // 包含球の半径
+	GLfloat axis[3];   // 法線の円錐の軸
+	GLfloat cutoff;    // 円錐の広がりの正弦 (1 なら裏向きでは間引かない)
+};
+
+/*
+ * @brief 三角形を隣接するものどうしでまとめてメッシュレットに分ける
+ * @param vertex:       頂点属性を格納した配列
+ * @param vertexcount:  頂点の数
+ * @param index:        三角形の頂点のインデックス
+ * @param indexcount:   インデックスの要素数
+ * @param result:       メッシュレットごとに並べ替えたインデックス
+ * @param meshlet:      メッシュレット
+ * @param maxVertices:  1 つのメッシュレットの頂点の最大数
+ * @param maxTriangles: 1 つのメッシュレットの三角形の最大数
+ * @param coneLimit:    円錐の軸と三角形の法線のなす角の余弦の下限 (これより外を向くものは加えない)
+ */
+inline void buildMeshlets(
+	const Object::Vertex* vertex,
+	GLsizei vertexcount,
+	const GLuint* index,
+	GLsizei indexcount,
+	std::vector<GLuint>& result,
+	std::vector<Meshlet>& meshlet,
+	GLsizei maxVertices = 64,
+	GLsizei maxTriangles = 124,
+	GLfloat coneLimit = 0.5f)
+{
+	const GLsizei triangles(indexcount / 3);
+	result.clear();
+	meshlet.clear();
+
+	// 三角形の単位法線 (面積のないものは 0)
+	std::vector<GLfloat> normal(triangles * 3);
+	for (GLsizei t = 0; t < triangles; ++t)
+	{
+		const GLfloat* const p0(vertex[index[t * 3]].position);
+		const GLfloat* const p1(vertex[index[t * 3 + 1]].position);
+		const GLfloat* const p2(vertex[index[t * 3 + 2]].position);
+		const GLfloat e1[] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const GLfloat e2[] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		GLfloat* const n(&normal[t * 3]);
+		n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+		const GLfloat l(sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+		if (l > 0.f)
+		{
+			n[0] /= l;
+			n[1] /= l;
+			n[2] /= l;
+		}
+	}
+
+	// 頂点を共有する三角形のリスト
+	std::vector<GLuint> offset(vertexcount + 1, 0);
+	for (GLsizei i = 0; i < triangles * 3; ++i) ++offset[index[i] + 1];
+	for (GLsizei v = 0; v < vertexcount; ++v) offset[v + 1] += offset[v];
+	std::vector<GLuint> adjacency(triangles * 3);
+	{
+		std::vector<GLuint> fill(offset.begin(), offset.end() - 1);
+		for (GLsizei i = 0; i < triangles * 3; ++i) adjacency[fill[index[i]]++] = i / 3;
+	}
+
+	std::vector<bool> used(triangles, false);
+	std::vector<GLint> slot(vertexcount, -1);
+	std::vector<GLuint> local;
+	std::vector<GLuint> member;
+	GLsizei seed(0);
+
+	for (;;)
+	{
+		while (seed < triangles && used[seed]) ++seed;
+		if (seed == triangles) break;
+
+		GLfloat sum[3] = { 0.f, 0.f, 0.f };
+		GLuint next(seed);
+		local.clear();
+		member.clear();
+
+		// 新たに加える頂点の少ない隣の三角形から順に加える
+		do
+		{
+			used[next] = true;
+			member.push_back(next);
+			for (int k = 0; k < 3; ++k)
+			{
+				const GLuint v(index[next * 3 + k]);
+				if (slot[v] < 0)
+				{
+					slot[v] = static_cast<GLint>(local.size());
+					local.push_back(v);
+				}
+				sum[k] += normal[next * 3 + k];
+			}
+			if (static_cast<GLsizei>(member.size()) >= maxTriangles) break;
+
+			const GLfloat l(sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]));
+			const GLfloat axis[] = { l > 0.f ? sum[0] / l : 0.f, l > 0.f ? sum[1] / l : 0.f, l > 0.f ? sum[2] / l : 0.f };
+
+			GLint best(-1);
+			int bestNew(4);
+			GLfloat bestDot(-2.f);
+			for (GLuint v : local)
+			{
+				for (GLuint a = offset[v]; a < offset[v + 1]; ++a)
+				{
+					const GLuint t(adjacency[a]);
+					if (used[t]) continue;
+
+					int added(0);
+					for (int k = 0; k < 3; ++k) if (slot[index[t * 3 + k]] < 0) ++added;
+					if (static_cast<GLsizei>(local.size()) + added > maxVertices) continue;
+
+					// 面積のない三角形は向きを問わない
+					const GLfloat* const n(&normal[t * 3]);
+					const bool degenerate(n[0] == 0.f && n[1] == 0.f && n[2] == 0.f);
+					const GLfloat d(degenerate ? 1.f : n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+					if (d < coneLimit) continue;
+
+					if (added < bestNew || (added == bestNew && d > bestDot))
+					{
+						best = static_cast<GLint>(t);
+						bestNew = added;
+						bestDot = d;
+					}
+				}
+			}
+			next = static_cast<GLuint>(best);
+		}
+		while (next != static_cast<GLuint>(-1));
+
+		Meshlet m;
+		m.first = static_cast<GLuint>(result.size());
+		m.count = static_cast<GLuint>(member.size() * 3);
+		for (GLuint t : member) result.insert(result.end(), index + t * 3, index + t * 3 + 3);
+
+		// 包含球
+		GLfloat lo[3], hi[3];
+		for (int k = 0; k < 3; ++k) lo[k] = hi[k] = vertex[local[0]].position[k];
+		for (GLuint v : local)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				lo[k] = std::min(lo[k], vertex[v].position[k]);
+				hi[k] = std::max(hi[k], vertex[v].position[k]);
+			}
+		}
+		for (int k = 0; k < 3; ++k) m.center[k] = (lo[k] + hi[k]) * 0.5f;
+
+		GLfloat r2(0.f);
+		for (GLuint v : local)
+		{
+			const GLfloat dx(vertex[v].position[0] - m.center[0]);
+			const GLfloat dy(vertex[v].position[1] - m.center[1]);
+			const GLfloat dz(vertex[v].position[2] - m.center[2]);
+			r2 = std::max(r2, dx * dx + dy * dy + dz * dz);
+			slot[v] = -1;
+		}
+		m.radius = sqrt(r2);
+
+		// 法線の円錐 (軸から最も離れた法線とのなす角の正弦)
+		const GLfloat l(sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]));
+		GLfloat minDot(l > 0.f ? 1.f : -1.f);
+		for (int k = 0; k < 3; ++k) m.axis[k] = l > 0.f ? sum[k] / l : 0.f;
+		for (GLuint t : member)
+		{
+			const GLfloat* const n(&normal[t * 3]);
+			if (n[0] == 0.f && n[1] == 0.f && n[2] == 0.f) continue;
+			minDot = std::min(minDot, n[0] * m.axis[0] + n[1] * m.axis[1] + n[2] * m.axis[2]);
+		}
+		m.cutoff = minDot > 0.f ? sqrt(1.f - minDot * minDot) : 1.f;
+
+		meshlet.push_back(m);
+	}
+}
+
+// メッシュレットを視錐台と裏向きで間引いて描画する範囲を求める
+class MeshletCuller
+{
+public:
+	struct Stats
+	{
+		GLsizei meshlets;  // メッシュレットの数
+		GLsizei visible;   // 残ったメッシュレットの数
+		GLsizei ranges;    // つなげた描画範囲の数
+		GLsizei triangles; // 三角形の数
+		GLsizei backface;  // 裏向きで間引いた三角形の数
+		GLsizei frustum;   // 視錐台の外で間引いた三角形の数
+		double ms;         // 間引きにかかった時間
+	};
+
+private:
+	std::vector<GLsizei> count;
+	std::vector<const GLvoid*> offset;
+	std::vector<GLuint> first;
+	Stats stats;
+
+public:
+	MeshletCuller()
+	 : stats()
+	{}
+
+	/*
+	 * @brief 見えるメッシュレットを選んで隣り合うものをつなげる
+	 * @param meshlet:    メッシュレット
+	 * @param modelview:  モデルビュー変換行列
+	 * @param projection: 投影変換行列
+	 * @param indexSize:  インデックスの 1 要素のバイト数
+	 */
+	void cull(const std::vector<Meshlet>& meshlet, const Matrix& modelview, const Matrix& projection,
+		GLsizei indexSize = sizeof(GLuint))
+	{
+		const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+		count.clear();
+		offset.clear();
+		first.clear();
+		stats = Stats();
+		stats.meshlets = static_cast<GLsizei>(meshlet.size());
+
+		// モデル座標系の視点
+		const GLfloat origin[] = { 0.f, 0.f, 0.f, 1.f };
+		GLfloat eye[4];
+		modelview.inverse().transform(origin, eye);
+
+		// モデル座標系の視錐台の 6 平面
+		const Matrix mvp(projection * modelview);
+		GLfloat plane[6][4];
+		for (int i = 0; i < 6; ++i)
+		{
+			const int row(i >> 1);
+			const GLfloat sign(i & 1 ? -1.f : 1.f);
+			for (int k = 0; k < 4; ++k) plane[i][k] = mvp[k * 4 + 3] + sign * mvp[k * 4 + row];
+
+			const GLfloat l(sqrt(plane[i][0] * plane[i][0] + plane[i][1] * plane[i][1] + plane[i][2] * plane[i][2]));
+			for (int k = 0; k < 4; ++k) plane[i][k] /= l;
+		}
+
+		GLuint end(static_cast<GLuint>(-1));
+		for (const Meshlet& m : meshlet)
+		{
+			const GLsizei triangles(static_cast<GLsizei>(m.count / 3));
+			stats.triangles += triangles;
+
+			// 包含球が平面の外側にあれば見えない
+			bool inside(true);
+			for (int i = 0; i < 6 && inside; ++i)
+				inside = plane[i][0] * m.center[0] + plane[i][1] * m.center[1] + plane[i][2] * m.center[2] + plane[i][3] >= -m.radius;
+			if (!inside)
+			{
+				stats.frustum += triangles;
+				continue;
+			}
+
+			// 視点が円錐を外れて裏側にあれば全ての三角形が裏向き
+			const GLfloat d[] = { m.center[0] - eye[0], m.center[1] - eye[1], m.center[2] - eye[2] };
+			if (d[0] * m.axis[0] + d[1] * m.axis[1] + d[2] * m.axis[2]
+				>= m.cutoff * sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) + m.radius)
+			{
+				stats.backface += triangles;
+				continue;
+			}
+
+			++stats.visible;
+			if (m.first == end)
+			{
+				count.back() += m.count;
+			}
+			else
+			{
+				count.push_back(m.count);
+				offset.push_back(static_cast<const GLubyte*>(0) + m.first * indexSize);
+				first.push_back(m.first);
+			}
+			end = m.first + m.count;
+		}
+
+		stats.ranges = static_cast<GLsizei>(count.size());
+		stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// glMultiDrawElements() に渡す要素数と位置
+	const GLsizei* getCount() const { return count.data(); }
+
+	const GLvoid* const* getOffset() const { return offset.data(); }
+
+	// 範囲ごとの先頭のインデックスの位置 (要素単位、トレースの記録用)
+	const GLuint* getFirst() const { return first.data(); }
+
+	GLsizei getRangeCount() const { return static_cast<GLsizei>(count.size()); }
+
+	const Stats& getStats() const { return stats; }
+};
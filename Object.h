@@ -1,5 +1,8 @@
 #pragma once
+#include <iostream>
+#include <vector>
 #include <GL/glew.h>
+#include "RetireQueue.h"
 
 class Object
 {
@@ -8,6 +11,9 @@ private:
 	GLuint vbo;
 	GLuint ibo;
 
+	// インデックスの型
+	GLenum type;
+
 public:
 	struct Vertex
 	{
@@ -26,6 +32,7 @@ public:
 		const Vertex* vertex,
 		GLsizei indexcount = 0,
 		const GLuint* index = NULL)
+	 : type(selectIndexType(vertexcount))
 	{
 		glGenVertexArrays(1, &vao);
 		glBindVertexArray(vao);
@@ -42,24 +49,129 @@ public:
 
 		glGenBuffers(1, &ibo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexcount * sizeof(GLuint), index, GL_STATIC_DRAW);
+		uploadIndex(type, vertexcount, indexcount, index);
 	}
 
 	virtual ~Object()
 	{
-		glDeleteVertexArrays(1, &vao);
-		glDeleteBuffers(1, &vbo);
-		glDeleteBuffers(1, &ibo);
+		retire(vao, vbo, ibo);
 	}
 
 private:
 	Object(const Object &o);
 	Object &operator=(const Object &o);
 
+	// 削除を待つ頂点配列オブジェクトとバッファオブジェクト
+	struct Names
+	{
+		GLuint vao;
+		GLuint vbo;
+		GLuint ibo;
+	};
+
+	// 描画中のフレームが終わるまで削除を待つオブジェクト (コンテキストのスレッドだけで使う)
+	static RetireQueue<Names>& retired()
+	{
+		static RetireQueue<Names> queue;
+		return queue;
+	}
+
+	static void remove(const Names& n)
+	{
+		glDeleteVertexArrays(1, &n.vao);
+		glDeleteBuffers(1, &n.vbo);
+		glDeleteBuffers(1, &n.ibo);
+	}
+
+public:
+	// 頂点配列オブジェクトとバッファオブジェクトの削除を描画中のフレームが終わるまで遅らせる
+	static void retire(GLuint vao, GLuint vbo, GLuint ibo)
+	{
+		retired().push(Names{ vao, vbo, ibo });
+	}
+
+	// フレームを進めて描画の終わったオブジェクトを削除する (Window::swapBuffers() で呼ぶ)
+	static void advance()
+	{
+		retired().advance(remove);
+	}
+
+	// 待たずに全て削除する (コンテキストを破棄する前)
+	static void clearRetired()
+	{
+		retired().clear(remove);
+	}
+
 public:
 	void bind() const
 	{
 		glBindVertexArray(vao);
 	}
+
+	// glDrawElements() に渡すインデックスの型
+	GLenum getIndexType() const
+	{
+		return type;
+	}
+
+	// 頂点の数に合わせたインデックスの型 (65536 頂点までなら 16 bit にして転送量を半分にする)
+	static GLenum selectIndexType(GLsizei vertexcount)
+	{
+		return vertexcount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
+
+	/*
+	 * @brief インデックスが全て頂点の範囲に収まっているか調べる
+	 *        範囲外のインデックスで描画すると GPU が頂点バッファの外を読む
+	 * @param vertexcount: 頂点の数
+	 * @param indexcount:  インデックスの要素数
+	 * @param index:       インデックスを格納した配列
+	 * @return             全て vertexcount 未満なら true
+	 */
+	static bool checkIndex(GLsizei vertexcount, GLsizei indexcount, const GLuint* index)
+	{
+		for (GLsizei i = 0; i < indexcount; ++i)
+			if (index[i] >= static_cast<GLuint>(vertexcount)) return false;
+		return true;
+	}
+
+	// インデックスの 1 要素のバイト数
+	static GLsizei getIndexSize(GLenum type)
+	{
+		return type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	}
+
+	/*
+	 * @brief 結合しているインデックスバッファにインデックスを指定した型で転送する
+	 *        頂点の範囲外のインデックスがあれば 16 bit に切り詰めると別の頂点を指し、
+	 *        そのままでも GPU が頂点バッファの外を読むので、代わりに全て 0 を転送する
+	 * @param type:        selectIndexType(vertexcount) で選んだ型
+	 * @param vertexcount: 頂点の数
+	 * @param indexcount:  インデックスの要素数
+	 * @param index:       インデックスを格納した配列
+	 * @return             インデックスが全て頂点の範囲に収まっていれば true
+	 */
+	static bool uploadIndex(GLenum type, GLsizei vertexcount, GLsizei indexcount, const GLuint* index)
+	{
+		if (!checkIndex(vertexcount, indexcount, index))
+		{
+			std::cerr << "Error: Index out of range: " << vertexcount << " vertices" << std::endl;
+			const std::vector<GLuint> zero(indexcount, 0);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexcount * getIndexSize(type), zero.data(), GL_STATIC_DRAW);
+			return false;
+		}
+
+		if (type == GL_UNSIGNED_SHORT && indexcount > 0)
+		{
+			const std::vector<GLushort> narrow(index, index + indexcount);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexcount * sizeof(GLushort), narrow.data(), GL_STATIC_DRAW);
+		}
+		else
+		{
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexcount * getIndexSize(type), index, GL_STATIC_DRAW);
+		}
+
+		return true;
+	}
 };
 
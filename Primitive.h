@@ -0,0 +1,596 @@
+#pragma once
+#include <cmath>
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <GL/glew.h>
+#include "Object.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// 基本形状の頂点とインデックスを作る
+// コンパイル時に作る関数テンプレートは constexpr の関数の中でのループや代入、
+// std::array の書き換えを使うので C++17 以降でコンパイルすること
+
+// コンパイル時に評価できる数学関数
+struct ConstMath
+{
+	static constexpr double pi = 3.14159265358979323846;
+
+	static constexpr double sin(double x)
+	{
+		// [-π, π] に寄せてからテイラー展開する
+		const double t(x / (2.0 * pi));
+		const long long n(static_cast<long long>(t < 0.0 ? t - 0.5 : t + 0.5));
+		x -= 2.0 * pi * n;
+
+		double term(x), sum(x);
+		for (int k = 1; k < 14; ++k)
+		{
+			term *= -x * x / ((2 * k) * (2 * k + 1));
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	static constexpr double cos(double x)
+	{
+		return sin(x + 0.5 * pi);
+	}
+
+	static constexpr double sqrt(double x)
+	{
+		if (x <= 0.0) return 0.0;
+
+		double y(x > 1.0 ? x : 1.0);
+		for (int k = 0; k < 64; ++k)
+		{
+			const double z(0.5 * (y + x / y));
+			if (z == y) break;
+			y = z;
+		}
+
+		return y;
+	}
+};
+
+// 実行時に使う数学関数
+struct RuntimeMath
+{
+	static double sin(double x) { return std::sin(x); }
+	static double cos(double x) { return std::cos(x); }
+	static double sqrt(double x) { return std::sqrt(x); }
+};
+
+// 基本形状の頂点とインデックスを作る
+// 頂点の作成は Math を差し替えてコンパイル時と実行時で同じ手順を使う
+// 裏面は反時計回りで見えない向きにしてある
+struct Primitive
+{
+	static constexpr void setVertex(Object::Vertex& v,
+		GLfloat px, GLfloat py, GLfloat pz,
+		GLfloat nx, GLfloat ny, GLfloat nz)
+	{
+		v.position[0] = px; v.position[1] = py; v.position[2] = pz;
+		v.normal[0] = nx; v.normal[1] = ny; v.normal[2] = nz;
+	}
+
+	static constexpr void setTriangle(GLuint* index, std::size_t& n, GLuint a, GLuint b, GLuint c)
+	{
+		index[n++] = a;
+		index[n++] = b;
+		index[n++] = c;
+	}
+
+	//
+	// 球 (slices: 経度方向の分割数, stacks: 緯度方向の分割数)
+	//
+	static constexpr std::size_t sphereVertexCount(std::size_t slices, std::size_t stacks)
+	{
+		return slices * (stacks + 1);
+	}
+
+	static constexpr std::size_t sphereIndexCount(std::size_t slices, std::size_t stacks)
+	{
+		return 6 * slices * (stacks - 1);
+	}
+
+	template <class Math>
+	static constexpr void sphereVertex(Object::Vertex* vertex, std::size_t slices, std::size_t stacks, GLfloat radius)
+	{
+		for (std::size_t j = 0; j <= stacks; ++j)
+		{
+			const double t(ConstMath::pi * j / stacks);
+			const double st(Math::sin(t)), ct(Math::cos(t));
+
+			for (std::size_t i = 0; i < slices; ++i)
+			{
+				const double p(2.0 * ConstMath::pi * i / slices);
+				const GLfloat nx(static_cast<GLfloat>(st * Math::cos(p)));
+				const GLfloat ny(static_cast<GLfloat>(ct));
+				const GLfloat nz(static_cast<GLfloat>(-st * Math::sin(p)));
+				setVertex(vertex[j * slices + i], nx * radius, ny * radius, nz * radius, nx, ny, nz);
+			}
+		}
+	}
+
+	static constexpr void sphereIndex(GLuint* index, std::size_t slices, std::size_t stacks)
+	{
+		std::size_t n(0);
+		for (std::size_t j = 0; j < stacks; ++j)
+		{
+			for (std::size_t i = 0; i < slices; ++i)
+			{
+				const GLuint a(static_cast<GLuint>(j * slices + i));
+				const GLuint b(static_cast<GLuint>(j * slices + (i + 1) % slices));
+				const GLuint c(static_cast<GLuint>(a + slices)), d(static_cast<GLuint>(b + slices));
+
+				// 極では三角形が潰れるので片方だけ作る
+				if (j > 0) setTriangle(index, n, a, c, b);
+				if (j < stacks - 1) setTriangle(index, n, b, c, d);
+			}
+		}
+	}
+
+	//
+	// トーラス (slices: 円環方向の分割数, sides: 管の断面の分割数)
+	//
+	static constexpr std::size_t torusVertexCount(std::size_t slices, std::size_t sides)
+	{
+		return slices * sides;
+	}
+
+	static constexpr std::size_t torusIndexCount(std::size_t slices, std::size_t sides)
+	{
+		return 6 * slices * sides;
+	}
+
+	template <class Math>
+	static constexpr void torusVertex(Object::Vertex* vertex, std::size_t slices, std::size_t sides, GLfloat outer, GLfloat inner)
+	{
+		for (std::size_t i = 0; i < slices; ++i)
+		{
+			const double p(2.0 * ConstMath::pi * i / slices);
+			const double sp(Math::sin(p)), cp(Math::cos(p));
+
+			for (std::size_t j = 0; j < sides; ++j)
+			{
+				const double t(2.0 * ConstMath::pi * j / sides);
+				const double st(Math::sin(t)), ct(Math::cos(t));
+				const GLfloat nx(static_cast<GLfloat>(ct * cp));
+				const GLfloat ny(static_cast<GLfloat>(st));
+				const GLfloat nz(static_cast<GLfloat>(-ct * sp));
+				setVertex(vertex[i * sides + j],
+					static_cast<GLfloat>(outer * cp) + inner * nx,
+					inner * ny,
+					static_cast<GLfloat>(-outer * sp) + inner * nz,
+					nx, ny, nz);
+			}
+		}
+	}
+
+	static constexpr void torusIndex(GLuint* index, std::size_t slices, std::size_t sides)
+	{
+		std::size_t n(0);
+		for (std::size_t i = 0; i < slices; ++i)
+		{
+			const std::size_t k((i + 1) % slices);
+			for (std::size_t j = 0; j < sides; ++j)
+			{
+				const std::size_t l((j + 1) % sides);
+				const GLuint a(static_cast<GLuint>(i * sides + j)), b(static_cast<GLuint>(i * sides + l));
+				const GLuint c(static_cast<GLuint>(k * sides + j)), d(static_cast<GLuint>(k * sides + l));
+				setTriangle(index, n, a, c, b);
+				setTriangle(index, n, b, c, d);
+			}
+		}
+	}
+
+	//
+	// 円柱 (slices: 円周の分割数, 上下のふたを含む)
+	//
+	static constexpr std::size_t cylinderVertexCount(std::size_t slices)
+	{
+		return 4 * slices + 2;
+	}
+
+	static constexpr std::size_t cylinderIndexCount(std::size_t slices)
+	{
+		return 12 * slices;
+	}
+
+	template <class Math>
+	static constexpr void cylinderVertex(Object::Vertex* vertex, std::size_t slices, GLfloat radius, GLfloat height)
+	{
+		const GLfloat h(height * 0.5f);
+		const std::size_t bottom(2 * slices), top(3 * slices + 1);
+		setVertex(vertex[bottom], 0.f, -h, 0.f, 0.f, -1.f, 0.f);
+		setVertex(vertex[top], 0.f, h, 0.f, 0.f, 1.f, 0.f);
+
+		for (std::size_t i = 0; i < slices; ++i)
+		{
+			const double p(2.0 * ConstMath::pi * i / slices);
+			const GLfloat nx(static_cast<GLfloat>(Math::cos(p)));
+			const GLfloat nz(static_cast<GLfloat>(-Math::sin(p)));
+			const GLfloat x(nx * radius), z(nz * radius);
+
+			// 側面
+			setVertex(vertex[i], x, -h, z, nx, 0.f, nz);
+			setVertex(vertex[slices + i], x, h, z, nx, 0.f, nz);
+
+			// ふた
+			setVertex(vertex[bottom + 1 + i], x, -h, z, 0.f, -1.f, 0.f);
+			setVertex(vertex[top + 1 + i], x, h, z, 0.f, 1.f, 0.f);
+		}
+	}
+
+	static constexpr void cylinderIndex(GLuint* index, std::size_t slices)
+	{
+		std::size_t n(0);
+		const GLuint bottom(static_cast<GLuint>(2 * slices)), top(static_cast<GLuint>(3 * slices + 1));
+
+		for (std::size_t i = 0; i < slices; ++i)
+		{
+			const GLuint a(static_cast<GLuint>(i)), b(static_cast<GLuint>((i + 1) % slices));
+			const GLuint c(static_cast<GLuint>(a + slices)), d(static_cast<GLuint>(b + slices));
+			setTriangle(index, n, a, b, c);
+			setTriangle(index, n, c, b, d);
+			setTriangle(index, n, bottom, bottom + 1 + b, bottom + 1 + a);
+			setTriangle(index, n, top, top + 1 + a, top + 1 + b);
+		}
+	}
+
+	//
+	// xz 平面上の格子 (xdiv, zdiv: 各方向の分割数)
+	//
+	static constexpr std::size_t gridVertexCount(std::size_t xdiv, std::size_t zdiv)
+	{
+		return (xdiv + 1) * (zdiv + 1);
+	}
+
+	static constexpr std::size_t gridIndexCount(std::size_t xdiv, std::size_t zdiv)
+	{
+		return 6 * xdiv * zdiv;
+	}
+
+	template <class Math>
+	static constexpr void gridVertex(Object::Vertex* vertex, std::size_t xdiv, std::size_t zdiv, GLfloat width, GLfloat depth)
+	{
+		for (std::size_t j = 0; j <= zdiv; ++j)
+		{
+			const GLfloat z(depth * (static_cast<GLfloat>(j) / zdiv - 0.5f));
+			for (std::size_t i = 0; i <= xdiv; ++i)
+			{
+				const GLfloat x(width * (static_cast<GLfloat>(i) / xdiv - 0.5f));
+				setVertex(vertex[j * (xdiv + 1) + i], x, 0.f, z, 0.f, 1.f, 0.f);
+			}
+		}
+	}
+
+	static constexpr void gridIndex(GLuint* index, std::size_t xdiv, std::size_t zdiv)
+	{
+		std::size_t n(0);
+		for (std::size_t j = 0; j < zdiv; ++j)
+		{
+			for (std::size_t i = 0; i < xdiv; ++i)
+			{
+				const GLuint a(static_cast<GLuint>(j * (xdiv + 1) + i)), b(a + 1);
+				const GLuint c(static_cast<GLuint>(a + xdiv + 1)), d(c + 1);
+				setTriangle(index, n, a, c, b);
+				setTriangle(index, n, b, c, d);
+			}
+		}
+	}
+
+	//
+	// 各面を division × division に分割した立方体
+	//
+	static constexpr std::size_t cubeVertexCount(std::size_t division)
+	{
+		return 6 * (division + 1) * (division + 1);
+	}
+
+	static constexpr std::size_t cubeIndexCount(std::size_t division)
+	{
+		return 36 * division * division;
+	}
+
+	template <class Math>
+	static constexpr void cubeVertex(Object::Vertex* vertex, std::size_t division, GLfloat size)
+	{
+		// 各面の法線と、面内の u, v 軸 (u × v = 法線)
+		constexpr GLfloat face[6][3][3] =
+		{
+			{ {  1.f, 0.f, 0.f }, { 0.f, 0.f, -1.f }, { 0.f, 1.f,  0.f } },
+			{ { -1.f, 0.f, 0.f }, { 0.f, 0.f,  1.f }, { 0.f, 1.f,  0.f } },
+			{ { 0.f,  1.f, 0.f }, { 1.f, 0.f,  0.f }, { 0.f, 0.f, -1.f } },
+			{ { 0.f, -1.f, 0.f }, { 1.f, 0.f,  0.f }, { 0.f, 0.f,  1.f } },
+			{ { 0.f, 0.f,  1.f }, { 1.f, 0.f,  0.f }, { 0.f, 1.f,  0.f } },
+			{ { 0.f, 0.f, -1.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f,  0.f } }
+		};
+		const GLfloat s(size * 0.5f);
+		std::size_t k(0);
+
+		for (int f = 0; f < 6; ++f)
+		{
+			const GLfloat (&n)[3](face[f][0]);
+			const GLfloat (&u)[3](face[f][1]);
+			const GLfloat (&v)[3](face[f][2]);
+
+			for (std::size_t j = 0; j <= division; ++j)
+			{
+				const GLfloat b(2.f * j / division - 1.f);
+				for (std::size_t i = 0; i <= division; ++i)
+				{
+					const GLfloat a(2.f * i / division - 1.f);
+					setVertex(vertex[k++],
+						(n[0] + a * u[0] + b * v[0]) * s,
+						(n[1] + a * u[1] + b * v[1]) * s,
+						(n[2] + a * u[2] + b * v[2]) * s,
+						n[0], n[1], n[2]);
+				}
+			}
+		}
+	}
+
+	static constexpr void cubeIndex(GLuint* index, std::size_t division)
+	{
+		std::size_t n(0);
+		const std::size_t row(division + 1);
+
+		for (std::size_t f = 0; f < 6; ++f)
+		{
+			const std::size_t base(f * row * row);
+			for (std::size_t j = 0; j < division; ++j)
+			{
+				for (std::size_t i = 0; i < division; ++i)
+				{
+					const GLuint a(static_cast<GLuint>(base + j * row + i)), b(a + 1);
+					const GLuint c(static_cast<GLuint>(a + row)), d(c + 1);
+					setTriangle(index, n, a, b, d);
+					setTriangle(index, n, a, d, c);
+				}
+			}
+		}
+	}
+};
+
+//
+// コンパイル時に作る基本形状
+// constexpr auto v(sphereVertex<32, 16>(1.f)); のように使う
+//
+template <std::size_t slices, std::size_t stacks>
+constexpr std::array<Object::Vertex, Primitive::sphereVertexCount(slices, stacks)> sphereVertex(GLfloat radius = 1.f)
+{
+	static_assert(slices >= 3 && stacks >= 2, "sphere needs at least 3 slices and 2 stacks");
+	std::array<Object::Vertex, Primitive::sphereVertexCount(slices, stacks)> vertex{};
+	Primitive::sphereVertex<ConstMath>(vertex.data(), slices, stacks, radius);
+	return vertex;
+}
+
+template <std::size_t slices, std::size_t stacks>
+constexpr std::array<GLuint, Primitive::sphereIndexCount(slices, stacks)> sphereIndex()
+{
+	std::array<GLuint, Primitive::sphereIndexCount(slices, stacks)> index{};
+	Primitive::sphereIndex(index.data(), slices, stacks);
+	return index;
+}
+
+template <std::size_t slices, std::size_t sides>
+constexpr std::array<Object::Vertex, Primitive::torusVertexCount(slices, sides)> torusVertex(GLfloat outer = 1.f, GLfloat inner = 0.25f)
+{
+	static_assert(slices >= 3 && sides >= 3, "torus needs at least 3 slices and 3 sides");
+	std::array<Object::Vertex, Primitive::torusVertexCount(slices, sides)> vertex{};
+	Primitive::torusVertex<ConstMath>(vertex.data(), slices, sides, outer, inner);
+	return vertex;
+}
+
+template <std::size_t slices, std::size_t sides>
+constexpr std::array<GLuint, Primitive::torusIndexCount(slices, sides)> torusIndex()
+{
+	std::array<GLuint, Primitive::torusIndexCount(slices, sides)> index{};
+	Primitive::torusIndex(index.data(), slices, sides);
+	return index;
+}
+
+template <std::size_t slices>
+constexpr std::array<Object::Vertex, Primitive::cylinderVertexCount(slices)> cylinderVertex(GLfloat radius = 1.f, GLfloat height = 2.f)
+{
+	static_assert(slices >= 3, "cylinder needs at least 3 slices");
+	std::array<Object::Vertex, Primitive::cylinderVertexCount(slices)> vertex{};
+	Primitive::cylinderVertex<ConstMath>(vertex.data(), slices, radius, height);
+	return vertex;
+}
+
+template <std::size_t slices>
+constexpr std::array<GLuint, Primitive::cylinderIndexCount(slices)> cylinderIndex()
+{
+	std::array<GLuint, Primitive::cylinderIndexCount(slices)> index{};
+	Primitive::cylinderIndex(index.data(), slices);
+	return index;
+}
+
+template <std::size_t xdiv, std::size_t zdiv>
+constexpr std::array<Object::Vertex, Primitive::gridVertexCount(xdiv, zdiv)> gridVertex(GLfloat width = 2.f, GLfloat depth = 2.f)
+{
+	static_assert(xdiv >= 1 && zdiv >= 1, "grid needs at least 1 division");
+	std::array<Object::Vertex, Primitive::gridVertexCount(xdiv, zdiv)> vertex{};
+	Primitive::gridVertex<ConstMath>(vertex.data(), xdiv, zdiv, width, depth);
+	return vertex;
+}
+
+template <std::size_t xdiv, std::size_t zdiv>
+constexpr std::array<GLuint, Primitive::gridIndexCount(xdiv, zdiv)> gridIndex()
+{
+	std::array<GLuint, Primitive::gridIndexCount(xdiv, zdiv)> index{};
+	Primitive::gridIndex(index.data(), xdiv, zdiv);
+	return index;
+}
+
+template <std::size_t division>
+constexpr std::array<Object::Vertex, Primitive::cubeVertexCount(division)> subdividedCubeVertex(GLfloat size = 2.f)
+{
+	static_assert(division >= 1, "cube needs at least 1 division");
+	std::array<Object::Vertex, Primitive::cubeVertexCount(division)> vertex{};
+	Primitive::cubeVertex<ConstMath>(vertex.data(), division, size);
+	return vertex;
+}
+
+template <std::size_t division>
+constexpr std::array<GLuint, Primitive::cubeIndexCount(division)> subdividedCubeIndex()
+{
+	std::array<GLuint, Primitive::cubeIndexCount(division)> index{};
+	Primitive::cubeIndex(index.data(), division);
+	return index;
+}
+
+//
+// 実行時に分割数を決める基本形状
+// 球とトーラスは三角関数の表を作って SIMD で 4 頂点ずつ計算する
+// 円柱と格子と立方体は SIMD を使わずコンパイル時と同じ処理を RuntimeMath で行う
+//
+#if defined(__SSE2__) || defined(_M_X64)
+// SoA で計算した 4 頂点を Object::Vertex の並びで書き込む
+inline void storeVertex4(Object::Vertex* v, __m128 px, __m128 py, __m128 pz, __m128 nx, __m128 ny, __m128 nz)
+{
+	__m128 zero(_mm_setzero_ps()), nw(_mm_setzero_ps());
+	_MM_TRANSPOSE4_PS(px, py, pz, nx);
+	_MM_TRANSPOSE4_PS(ny, nz, zero, nw);
+
+	// position[0..2], normal[0] と normal[1..2] に分けて書く
+	GLfloat* const f(v->position);
+	_mm_storeu_ps(f + 0, px); _mm_storel_pi(reinterpret_cast<__m64*>(f + 4), ny);
+	_mm_storeu_ps(f + 6, py); _mm_storel_pi(reinterpret_cast<__m64*>(f + 10), nz);
+	_mm_storeu_ps(f + 12, pz); _mm_storel_pi(reinterpret_cast<__m64*>(f + 16), zero);
+	_mm_storeu_ps(f + 18, nx); _mm_storel_pi(reinterpret_cast<__m64*>(f + 22), nw);
+}
+#endif
+
+inline void sphereVertex(std::vector<Object::Vertex>& vertex, std::size_t slices, std::size_t stacks, GLfloat radius = 1.f)
+{
+	vertex.resize(Primitive::sphereVertexCount(slices, stacks));
+
+	std::vector<GLfloat> cp(slices), sp(slices);
+	for (std::size_t i = 0; i < slices; ++i)
+	{
+		const double p(2.0 * ConstMath::pi * i / slices);
+		cp[i] = static_cast<GLfloat>(std::cos(p));
+		sp[i] = static_cast<GLfloat>(-std::sin(p));
+	}
+
+	for (std::size_t j = 0; j <= stacks; ++j)
+	{
+		const double t(ConstMath::pi * j / stacks);
+		const GLfloat st(static_cast<GLfloat>(std::sin(t))), ct(static_cast<GLfloat>(std::cos(t)));
+		Object::Vertex* const row(&vertex[j * slices]);
+		std::size_t i(0);
+
+#if defined(__SSE2__) || defined(_M_X64)
+		const __m128 vst(_mm_set1_ps(st)), vr(_mm_set1_ps(radius));
+		const __m128 ny(_mm_set1_ps(ct)), py(_mm_set1_ps(ct * radius));
+		for (; i + 4 <= slices; i += 4)
+		{
+			const __m128 nx(_mm_mul_ps(vst, _mm_loadu_ps(&cp[i])));
+			const __m128 nz(_mm_mul_ps(vst, _mm_loadu_ps(&sp[i])));
+			storeVertex4(row + i, _mm_mul_ps(nx, vr), py, _mm_mul_ps(nz, vr), nx, ny, nz);
+		}
+#endif
+		for (; i < slices; ++i)
+		{
+			const GLfloat nx(st * cp[i]), nz(st * sp[i]);
+			Primitive::setVertex(row[i], nx * radius, ct * radius, nz * radius, nx, ct, nz);
+		}
+	}
+}
+
+inline void sphereIndex(std::vector<GLuint>& index, std::size_t slices, std::size_t stacks)
+{
+	index.resize(Primitive::sphereIndexCount(slices, stacks));
+	Primitive::sphereIndex(index.data(), slices, stacks);
+}
+
+inline void torusVertex(std::vector<Object::Vertex>& vertex, std::size_t slices, std::size_t sides, GLfloat outer = 1.f, GLfloat inner = 0.25f)
+{
+	vertex.resize(Primitive::torusVertexCount(slices, sides));
+
+	std::vector<GLfloat> ct(sides), st(sides);
+	for (std::size_t j = 0; j < sides; ++j)
+	{
+		const double t(2.0 * ConstMath::pi * j / sides);
+		ct[j] = static_cast<GLfloat>(std::cos(t));
+		st[j] = static_cast<GLfloat>(std::sin(t));
+	}
+
+	for (std::size_t i = 0; i < slices; ++i)
+	{
+		const double p(2.0 * ConstMath::pi * i / slices);
+		const GLfloat cp(static_cast<GLfloat>(std::cos(p))), sp(static_cast<GLfloat>(-std::sin(p)));
+		Object::Vertex* const ring(&vertex[i * sides]);
+		std::size_t j(0);
+
+#if defined(__SSE2__) || defined(_M_X64)
+		const __m128 vcp(_mm_set1_ps(cp)), vsp(_mm_set1_ps(sp));
+		const __m128 vi(_mm_set1_ps(inner));
+		const __m128 cx(_mm_set1_ps(outer * cp)), cz(_mm_set1_ps(outer * sp));
+		for (; j + 4 <= sides; j += 4)
+		{
+			const __m128 c(_mm_loadu_ps(&ct[j]));
+			const __m128 nx(_mm_mul_ps(c, vcp)), ny(_mm_loadu_ps(&st[j])), nz(_mm_mul_ps(c, vsp));
+			storeVertex4(ring + j,
+				_mm_add_ps(cx, _mm_mul_ps(vi, nx)),
+				_mm_mul_ps(vi, ny),
+				_mm_add_ps(cz, _mm_mul_ps(vi, nz)),
+				nx, ny, nz);
+		}
+#endif
+		for (; j < sides; ++j)
+		{
+			const GLfloat nx(ct[j] * cp), ny(st[j]), nz(ct[j] * sp);
+			Primitive::setVertex(ring[j], outer * cp + inner * nx, inner * ny, outer * sp + inner * nz, nx, ny, nz);
+		}
+	}
+}
+
+inline void torusIndex(std::vector<GLuint>& index, std::size_t slices, std::size_t sides)
+{
+	index.resize(Primitive::torusIndexCount(slices, sides));
+	Primitive::torusIndex(index.data(), slices, sides);
+}
+
+inline void cylinderVertex(std::vector<Object::Vertex>& vertex, std::size_t slices, GLfloat radius = 1.f, GLfloat height = 2.f)
+{
+	vertex.resize(Primitive::cylinderVertexCount(slices));
+	Primitive::cylinderVertex<RuntimeMath>(vertex.data(), slices, radius, height);
+}
+
+inline void cylinderIndex(std::vector<GLuint>& index, std::size_t slices)
+{
+	index.resize(Primitive::cylinderIndexCount(slices));
+	Primitive::cylinderIndex(index.data(), slices);
+}
+
+inline void gridVertex(std::vector<Object::Vertex>& vertex, std::size_t xdiv, std::size_t zdiv, GLfloat width = 2.f, GLfloat depth = 2.f)
+{
+	vertex.resize(Primitive::gridVertexCount(xdiv, zdiv));
+	Primitive::gridVertex<RuntimeMath>(vertex.data(), xdiv, zdiv, width, depth);
+}
+
+inline void gridIndex(std::vector<GLuint>& index, std::size_t xdiv, std::size_t zdiv)
+{
+	index.resize(Primitive::gridIndexCount(xdiv, zdiv));
+	Primitive::gridIndex(index.data(), xdiv, zdiv);
+}
+
+inline void subdividedCubeVertex(std::vector<Object::Vertex>& vertex, std::size_t division, GLfloat size = 2.f)
+{
+	vertex.resize(Primitive::cubeVertexCount(division));
+	Primitive::cubeVertex<RuntimeMath>(vertex.data(), division, size);
+}
+
+inline void subdividedCubeIndex(std::vector<GLuint>& index, std::size_t division)
+{
+	index.resize(Primitive::cubeIndexCount(division));
+	Primitive::cubeIndex(index.data(), division);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cmath>
+#include <GL/glew.h>
+#include "Matrix.h"
+
+// ワールド座標系の半直線
+struct Ray
+{
+	GLfloat origin[3];
+	GLfloat direction[3];
+
+	/*
+	 * @brief 画面上の点を通る視線を求める
+	 * @param x, y:          ウィンドウ座標系の位置 (左上が原点)
+	 * @param width, height: ウィンドウの大きさ
+	 * @param projection:    投影変換行列
+	 * @param view:          ビュー変換行列
+	 * @return               前方クリッピング面上の点から奥に向かう半直線
+	 */
+	static Ray unproject(
+		GLfloat x, GLfloat y,
+		GLfloat width, GLfloat height,
+		const Matrix& projection,
+		const Matrix& view)
+	{
+		const Matrix inverse((projection * view).inverse());
+
+		// 正規化デバイス座標系の前方と後方のクリッピング面上の点
+		const GLfloat nx(x * 2.f / width - 1.f);
+		const GLfloat ny(1.f - y * 2.f / height);
+		const GLfloat clip[2][4] = { { nx, ny, -1.f, 1.f }, { nx, ny, 1.f, 1.f } };
+
+		GLfloat p[2][4];
+		inverse.transform(clip[0], p[0]);
+		inverse.transform(clip[1], p[1]);
+
+		Ray ray;
+		for (int i = 0; i < 3; ++i)
+		{
+			ray.origin[i] = p[0][i] / p[0][3];
+			ray.direction[i] = p[1][i] / p[1][3] - ray.origin[i];
+		}
+
+		const GLfloat l(sqrt(ray.direction[0] * ray.direction[0] + ray.direction[1] * ray.direction[1] + ray.direction[2] * ray.direction[2]));
+		if (l > 0.f)
+		{
+			ray.direction[0] /= l;
+			ray.direction[1] /= l;
+			ray.direction[2] /= l;
+		}
+
+		return ray;
+	}
+};
@@ -0,0 +1,317 @@
+#pragma once
+#include <mutex>
+#include <vector>
+#include <GL/glew.h>
+#include "HandlePool.h"
+#include "RetireQueue.h"
+#include "Object.h"
+
+// 形状の GL のオブジェクトと描画方法
+struct MeshResource
+{
+	GLuint vao;
+	GLuint vbo;
+	GLuint ibo;
+	GLenum mode;   // 基本図形
+	GLsizei count; // 描く頂点またはインデックスの数
+	bool indexed;  // インデックスを使うか
+	GLenum type;   // インデックスの型
+};
+
+struct ProgramResource
+{
+	GLuint program;
+};
+
+struct BufferResource
+{
+	GLuint buffer;
+	GLenum target;
+	GLsizeiptr size;
+};
+
+typedef Handle<MeshResource> MeshHandle;
+typedef Handle<ProgramResource> ProgramHandle;
+typedef Handle<BufferResource> BufferHandle;
+
+// GL のオブジェクトを世代付きのハンドルで管理する
+// 削除は描画中のフレームが終わるまで待ってから GL のコンテキストのスレッドで行う
+// release() 以外はコンテキストのスレッドから呼ぶ
+class ResourceManager
+{
+public:
+	struct Stats
+	{
+		std::size_t meshes;   // 有効な形状の数
+		std::size_t programs; // 有効なプログラムの数
+		std::size_t buffers;  // 有効なバッファの数
+		std::size_t pending;  // 削除待ちの GL のオブジェクトの数
+		std::size_t deleted;  // これまでに削除した GL のオブジェクトの数
+	};
+
+private:
+	HandlePool<MeshResource> meshes;
+	HandlePool<ProgramResource> programs;
+	HandlePool<BufferResource> buffers;
+
+	// 削除待ちの GL のオブジェクト
+	enum Kind { VertexArray, Buffer, Program };
+	struct Garbage
+	{
+		Kind kind;
+		GLuint name;
+	};
+	RetireQueue<Garbage> garbage;
+
+	// 他のスレッドから解放を要求されたハンドル
+	std::mutex mutex;
+	std::vector<MeshHandle> releasedMeshes;
+	std::vector<ProgramHandle> releasedPrograms;
+	std::vector<BufferHandle> releasedBuffers;
+
+	std::size_t deleted;
+
+public:
+	// frames: 同時に描画中のフレームの数 (この数のフレームが終わってから削除する)
+	ResourceManager(GLuint frames = 3)
+	 : garbage(frames),
+	   deleted(0)
+	{}
+
+	// コンテキストが有効なうちに破棄すること
+	virtual ~ResourceManager()
+	{
+		meshes.forEach([this](MeshResource& m) { discard(m); });
+		programs.forEach([this](ProgramResource& p) { discard(p); });
+		buffers.forEach([this](BufferResource& b) { discard(b); });
+
+		garbage.clear([this](const Garbage& g) { remove(g); });
+	}
+
+private:
+	ResourceManager(const ResourceManager &o);
+	ResourceManager &operator=(const ResourceManager &o);
+
+	void discard(const MeshResource& m)
+	{
+		garbage.push(Garbage{ VertexArray, m.vao });
+		garbage.push(Garbage{ Buffer, m.vbo });
+		garbage.push(Garbage{ Buffer, m.ibo });
+	}
+
+	void discard(const ProgramResource& p)
+	{
+		garbage.push(Garbage{ Program, p.program });
+	}
+
+	void discard(const BufferResource& b)
+	{
+		garbage.push(Garbage{ Buffer, b.buffer });
+	}
+
+	void remove(const Garbage& g)
+	{
+		switch (g.kind)
+		{
+		case VertexArray: glDeleteVertexArrays(1, &g.name); break;
+		case Buffer: glDeleteBuffers(1, &g.name); break;
+		case Program: glDeleteProgram(g.name); break;
+		}
+		++deleted;
+	}
+
+public:
+	/*
+	 * @brief 形状を作る
+	 * @param mode: 基本図形
+	 * 他の引数は Object と同じ (indexcount が 0 ならインデックスを使わない)
+	 * @return      形状のハンドル
+	 */
+	MeshHandle createMesh(GLenum mode, GLint size,
+		GLsizei vertexcount, const Object::Vertex* vertex,
+		GLsizei indexcount = 0, const GLuint* index = NULL)
+	{
+		MeshResource m;
+		m.mode = mode;
+		m.count = indexcount > 0 ? indexcount : vertexcount;
+		m.indexed = indexcount > 0;
+		m.type = Object::selectIndexType(vertexcount);
+
+		glGenVertexArrays(1, &m.vao);
+		glBindVertexArray(m.vao);
+
+		glGenBuffers(1, &m.vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m.vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertexcount * sizeof(Object::Vertex), vertex, GL_STATIC_DRAW);
+
+		glVertexAttribPointer(0, size, GL_FLOAT, GL_FALSE, sizeof(Object::Vertex), static_cast<Object::Vertex*>(0)->position);
+		glEnableVertexAttribArray(0);
+
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Object::Vertex), static_cast<Object::Vertex*>(0)->normal);
+		glEnableVertexAttribArray(1);
+
+		glGenBuffers(1, &m.ibo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.ibo);
+		Object::uploadIndex(m.type, vertexcount, indexcount, index);
+
+		glBindVertexArray(0);
+
+		const MeshHandle h(meshes.create(m));
+		if (!h) discard(m);
+		return h;
+	}
+
+	/*
+	 * @brief プログラムオブジェクトを管理下に置く
+	 * @param program: createProgram() などで作ったプログラムオブジェクト
+	 * @return         プログラムのハンドル
+	 */
+	ProgramHandle adoptProgram(GLuint program)
+	{
+		const ProgramResource p{ program };
+		const ProgramHandle h(programs.create(p));
+		if (!h) discard(p);
+		return h;
+	}
+
+	/*
+	 * @brief バッファオブジェクトを作る
+	 * @param target: 結合先
+	 * @param size:   大きさ
+	 * @param data:   初期値 (NULL なら未定義)
+	 * @param usage:  使い方
+	 * @return        バッファのハンドル
+	 */
+	BufferHandle createBuffer(GLenum target, GLsizeiptr size, const GLvoid* data = NULL, GLenum usage = GL_STATIC_DRAW)
+	{
+		BufferResource b{ 0, target, size };
+		glGenBuffers(1, &b.buffer);
+		glBindBuffer(target, b.buffer);
+		glBufferData(target, size, data, usage);
+		glBindBuffer(target, 0);
+
+		const BufferHandle h(buffers.create(b));
+		if (!h) discard(b);
+		return h;
+	}
+
+	// ハンドルの指す資源 (古いハンドルなら NULL)
+	const MeshResource* get(MeshHandle h) const { return meshes.get(h); }
+
+	const ProgramResource* get(ProgramHandle h) const { return programs.get(h); }
+
+	const BufferResource* get(BufferHandle h) const { return buffers.get(h); }
+
+	bool valid(MeshHandle h) const { return meshes.valid(h); }
+
+	bool valid(ProgramHandle h) const { return programs.valid(h); }
+
+	bool valid(BufferHandle h) const { return buffers.valid(h); }
+
+	/*
+	 * @brief 形状を描く
+	 * @param h: 形状のハンドル
+	 * @return   古いハンドルなら描かずに false
+	 */
+	bool draw(MeshHandle h) const
+	{
+		const MeshResource* const m(meshes.get(h));
+		if (m == NULL) return false;
+
+		glBindVertexArray(m->vao);
+		if (m->indexed)
+			glDrawElements(m->mode, m->count, m->type, 0);
+		else
+			glDrawArrays(m->mode, 0, m->count);
+		return true;
+	}
+
+	// プログラムを使う (古いハンドルなら false)
+	bool use(ProgramHandle h) const
+	{
+		const ProgramResource* const p(programs.get(h));
+		if (p == NULL) return false;
+
+		glUseProgram(p->program);
+		return true;
+	}
+
+	/*
+	 * @brief 資源を解放する
+	 *        ハンドルはすぐに無効になり、GL のオブジェクトは描画中のフレームが終わってから削除する
+	 * @param h: 解放するハンドル
+	 * @return   古いハンドルなら false
+	 */
+	bool destroy(MeshHandle h)
+	{
+		const MeshResource* const m(meshes.get(h));
+		if (m == NULL) return false;
+
+		discard(*m);
+		return meshes.destroy(h);
+	}
+
+	bool destroy(ProgramHandle h)
+	{
+		const ProgramResource* const p(programs.get(h));
+		if (p == NULL) return false;
+
+		discard(*p);
+		return programs.destroy(h);
+	}
+
+	bool destroy(BufferHandle h)
+	{
+		const BufferResource* const b(buffers.get(h));
+		if (b == NULL) return false;
+
+		discard(*b);
+		return buffers.destroy(h);
+	}
+
+	// 他のスレッドから解放を要求する (次の retire() で destroy() する)
+	void release(MeshHandle h)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		releasedMeshes.push_back(h);
+	}
+
+	void release(ProgramHandle h)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		releasedPrograms.push_back(h);
+	}
+
+	void release(BufferHandle h)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		releasedBuffers.push_back(h);
+	}
+
+	/*
+	 * @brief フレームの終わりに描画スレッドから呼ぶ
+	 *        解放を要求されたハンドルを無効にし、描画の終わったフレームの削除待ちを削除する
+	 */
+	void retire()
+	{
+		std::vector<MeshHandle> m;
+		std::vector<ProgramHandle> p;
+		std::vector<BufferHandle> b;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			m.swap(releasedMeshes);
+			p.swap(releasedPrograms);
+			b.swap(releasedBuffers);
+		}
+		for (MeshHandle h : m) destroy(h);
+		for (ProgramHandle h : p) destroy(h);
+		for (BufferHandle h : b) destroy(h);
+
+		garbage.advance([this](const Garbage& g) { remove(g); });
+	}
+
+	Stats getStats() const
+	{
+		return Stats{ meshes.size(), programs.size(), buffers.size(), garbage.size(), deleted };
+	}
+};
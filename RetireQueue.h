@@ -0,0 +1,62 @@
+#pragma once
+#include <deque>
+#include <GL/glew.h>
+
+// 描画中のフレームが終わるまで破棄を遅らせる値の列 (GL は呼ばない)
+// 値を積んだフレームから frames フレーム進んだら古い順に取り出す
+template <typename T>
+class RetireQueue
+{
+	struct Entry
+	{
+		GLuint frame; // 積んだときのフレーム
+		T value;
+	};
+
+	std::deque<Entry> queue;
+
+	// 同時に描画中のフレームの数
+	const GLuint frames;
+	GLuint frame;
+
+public:
+	// frames: 同時に描画中のフレームの数 (この数のフレームが終わってから取り出す)
+	RetireQueue(GLuint frames = 3)
+	 : frames(frames),
+	   frame(0)
+	{}
+
+	// 今のフレームで破棄を要求する
+	void push(const T& value)
+	{
+		queue.push_back(Entry{ frame, value });
+	}
+
+	/*
+	 * @brief フレームを進めて描画の終わった値を取り出す
+	 * @param func: 取り出した値を受け取る関数 (積んだ順に呼ぶ)
+	 */
+	template <typename Func>
+	void advance(Func func)
+	{
+		++frame;
+		while (!queue.empty() && frame - queue.front().frame >= frames)
+		{
+			func(queue.front().value);
+			queue.pop_front();
+		}
+	}
+
+	// 待たずに全て取り出す (コンテキストを破棄する前)
+	template <typename Func>
+	void clear(Func func)
+	{
+		for (const Entry& e : queue) func(e.value);
+		queue.clear();
+	}
+
+	// 破棄を待っている値の数
+	std::size_t size() const { return queue.size(); }
+
+	GLuint getFrame() const { return frame; }
+};
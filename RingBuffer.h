@@ -0,0 +1,103 @@
+#pragma once
+#include <deque>
+#include <GL/glew.h>
+
+// リングバッファの領域管理 (GL は呼ばない)
+// 各フレームで書き込んだ領域の終端とフェンスを記録し、
+// GPU が読み終えたフェンスから順に領域を解放する
+class RingBuffer
+{
+public:
+	struct Frame
+	{
+		GLsizeiptr end;  // このフレームで書き込んだ領域の終端
+		GLsizeiptr size; // このフレームが使っている大きさ (折り返しの隙間を含む)
+		GLsync fence;    // このフレームの描画命令の後に置いたフェンス
+	};
+
+private:
+	const GLsizeiptr capacity;
+	GLsizeiptr head;    // 次に書き込む位置
+	GLsizeiptr tail;    // GPU が読んでいる可能性のある最も古い位置
+	GLsizeiptr used;    // 使用中の領域の大きさ
+	GLsizeiptr pending; // まだフェンスを置いていない領域の大きさ
+	std::deque<Frame> frames;
+
+public:
+	RingBuffer(GLsizeiptr capacity)
+	 : capacity(capacity), head(0), tail(0), used(0), pending(0)
+	{}
+
+	/*
+	 * @brief 連続した領域を確保する
+	 * @param size:      確保する大きさ
+	 * @param alignment: 先頭位置の境界 (頂点の大きさのように 2 のべき乗でなくてもよい)
+	 * @return           先頭位置、空きがなければ -1
+	 */
+	GLsizeiptr allocate(GLsizeiptr size, GLsizeiptr alignment = 1)
+	{
+		if (size <= 0 || size > capacity || alignment <= 0) return -1;
+
+		GLsizeiptr offset((head + alignment - 1) / alignment * alignment);
+		GLsizeiptr skip(offset - head);
+
+		// 末尾に収まらなければ先頭に戻る
+		if (offset + size > capacity)
+		{
+			skip = capacity - head;
+			offset = 0;
+		}
+
+		if (used + skip + size > capacity) return -1;
+
+		head = offset + size;
+		if (head == capacity) head = 0;
+		used += skip + size;
+		pending += skip + size;
+
+		return offset;
+	}
+
+	/*
+	 * @brief 直前のフェンス以降に確保した領域をフレームとして閉じる
+	 * @param fence: 描画命令の後に置いたフェンス
+	 */
+	void submit(GLsync fence)
+	{
+		frames.push_back(Frame{ head, pending, fence });
+		pending = 0;
+	}
+
+	// GPU が読み終えた最も古いフレームの領域を解放する
+	void retire()
+	{
+		if (frames.empty()) return;
+
+		tail = frames.front().end;
+		used -= frames.front().size;
+		frames.pop_front();
+	}
+
+	// 最も古い処理中のフレーム
+	const Frame* oldest() const
+	{
+		return frames.empty() ? NULL : &frames.front();
+	}
+
+	// 全ての領域を空にする (バッファを作り直したとき)
+	void reset()
+	{
+		head = tail = used = pending = 0;
+		frames.clear();
+	}
+
+	GLsizeiptr getCapacity() const { return capacity; }
+
+	GLsizeiptr getUsed() const { return used; }
+
+	GLsizeiptr getHead() const { return head; }
+
+	GLsizeiptr getTail() const { return tail; }
+
+	std::size_t getFrameCount() const { return frames.size(); }
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <limits>
+#include <vector>
+#include <GL/glew.h>
+#include "Matrix.h"
+#include "Shape.h"
+#include "Bvh.h"
+#include "Ray.h"
+
+// 配置した形状 (インスタンス) に対する BVH
+class SceneBvh
+{
+public:
+	struct Hit
+	{
+		const Shape* shape;     // 当たった形状
+		GLuint instance;        // add() した順の番号
+		GLuint triangle;        // 形状のインデックス配列での三角形の番号
+		GLfloat t;              // 半直線の始点 (前方クリッピング面上) からのパラメータ (ワールド座標系の方向ベクトルの長さが単位)
+		GLfloat barycentric[3]; // 三角形の 3 頂点の重み
+	};
+
+private:
+	struct Instance
+	{
+		const Shape* shape;
+		const MeshBvh* mesh;
+		Matrix model;
+		Matrix inverse;
+	};
+
+	std::vector<Instance> instance;
+	std::vector<BvhNode> node;
+	std::vector<GLuint> order;
+
+public:
+	/*
+	 * @brief インスタンスを追加する (build() を呼ぶまで反映されない)
+	 * @param shape: 描画に使う形状
+	 * @param mesh:  形状の三角形の BVH
+	 * @param model: モデル変換行列
+	 * @return       インスタンスの番号
+	 */
+	GLuint add(const Shape* shape, const MeshBvh* mesh, const Matrix& model)
+	{
+		instance.push_back(Instance{ shape, mesh, model, model.inverse() });
+		return static_cast<GLuint>(instance.size() - 1);
+	}
+
+	// モデル変換行列を更新する (build() を呼ぶまで反映されない)
+	void setModel(GLuint i, const Matrix& model)
+	{
+		instance[i].model = model;
+		instance[i].inverse = model.inverse();
+	}
+
+	void clear()
+	{
+		instance.clear();
+		node.clear();
+		order.clear();
+	}
+
+	// インスタンスの境界ボックスから上位の BVH を作り直す
+	void build()
+	{
+		std::vector<Aabb> box(instance.size());
+
+		for (std::size_t i = 0; i < instance.size(); ++i)
+		{
+			box[i].reset();
+			if (instance[i].mesh->empty()) continue;
+
+			// モデル座標系の境界ボックスの 8 頂点を変換する
+			const Aabb& b(instance[i].mesh->getBounds());
+			for (int c = 0; c < 8; ++c)
+			{
+				const GLfloat p[] = { c & 1 ? b.hi[0] : b.lo[0], c & 2 ? b.hi[1] : b.lo[1], c & 4 ? b.hi[2] : b.lo[2], 1.f };
+				GLfloat q[4];
+				instance[i].model.transform(p, q);
+				box[i].extend(q);
+			}
+		}
+
+		buildBvh(box, node, order, 1);
+	}
+
+	/*
+	 * @brief 半直線と最も近くで交わる三角形を求める
+	 * @param ray: ワールド座標系の半直線
+	 * @param hit: 交点
+	 * @return     交点があれば true
+	 */
+	bool intersect(const Ray& ray, Hit& hit) const
+	{
+		if (node.empty()) return false;
+
+		const GLfloat inverse[] = { 1.f / ray.direction[0], 1.f / ray.direction[1], 1.f / ray.direction[2] };
+		GLfloat tmax(std::numeric_limits<GLfloat>::max());
+		bool found(false);
+
+		GLuint stack[bvhStackSize];
+		int top(0);
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			const GLuint self(stack[--top]);
+			const BvhNode& n(node[self]);
+			if (n.box.intersect(ray.origin, inverse, tmax) >= tmax) continue;
+
+			if (n.count == 0)
+			{
+				stack[top++] = n.index;
+				stack[top++] = self + 1;
+				continue;
+			}
+
+			for (GLuint i = n.index; i < n.index + n.count; ++i)
+			{
+				const Instance& s(instance[order[i]]);
+
+				// モデル座標系に移す、方向は正規化しないので t はそのまま使える
+				const GLfloat o[] = { ray.origin[0], ray.origin[1], ray.origin[2], 1.f };
+				const GLfloat d[] = { ray.direction[0], ray.direction[1], ray.direction[2], 0.f };
+				GLfloat origin[4], direction[4];
+				s.inverse.transform(o, origin);
+				s.inverse.transform(d, direction);
+
+				MeshBvh::Hit h;
+				if (!s.mesh->intersect(origin, direction, tmax, h)) continue;
+
+				tmax = h.t;
+				hit.shape = s.shape;
+				hit.instance = order[i];
+				hit.triangle = h.triangle;
+				hit.t = h.t;
+				hit.barycentric[0] = 1.f - h.u - h.v;
+				hit.barycentric[1] = h.u;
+				hit.barycentric[2] = h.v;
+				found = true;
+			}
+		}
+
+		return found;
+	}
+
+	std::size_t getInstanceCount() const
+	{
+		return instance.size();
+	}
+};
@@ -9,6 +9,14 @@ class Shape
 protected:
 	const GLsizei vertexCount;
 
+	// インデックスの型 (頂点が少なければ GL_UNSIGNED_SHORT)
+	const GLenum indexType;
+
+	void bind() const
+	{
+		object->bind();
+	}
+
 public:
 	Shape(
 		GLint size,
@@ -17,12 +25,13 @@ public:
 		GLsizei indexcount = 0,
 		const GLuint* index = NULL)
 	 : object(new Object(size, vertexcount, vertex, indexcount, index)),
-	   vertexCount(vertexcount)
+	   vertexCount(vertexcount),
+	   indexType(object->getIndexType())
 	{}
 
 	void draw() const
 	{
-		object->bind();
+		bind();
 		execute();
 	}
 
@@ -19,7 +19,7 @@ public:
 
 	virtual void execute() const
 	{
-		glDrawElements(GL_LINES, indexcount, GL_UNSIGNED_INT, 0);
+		glDrawElements(GL_LINES, indexcount, indexType, 0);
 	}
 
 };
\ No newline at end of file
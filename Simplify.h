@@ -0,0 +1,454 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <GL/glew.h>
+#include "Object.h"
+
+// 二次誤差メトリック (Quadric Error Metric)
+class Quadric
+{
+	// 対称行列の上三角 (a2, ab, ac, ad, b2, bc, bd, c2, cd, d2)
+	GLdouble q[10];
+
+	// 加えた平面の重みの合計
+	GLdouble weight;
+
+public:
+	Quadric()
+	 : weight(0.0)
+	{
+		std::fill(q, q + 10, 0.0);
+	}
+
+	// 平面 ax + by + cz + d = 0 の二次誤差
+	Quadric(GLdouble a, GLdouble b, GLdouble c, GLdouble d, GLdouble w = 1.0)
+	 : weight(w)
+	{
+		q[0] = w * a * a; q[1] = w * a * b; q[2] = w * a * c; q[3] = w * a * d;
+		q[4] = w * b * b; q[5] = w * b * c; q[6] = w * b * d;
+		q[7] = w * c * c; q[8] = w * c * d;
+		q[9] = w * d * d;
+	}
+
+	Quadric& operator+=(const Quadric& o)
+	{
+		for (int i = 0; i < 10; ++i) q[i] += o.q[i];
+		weight += o.weight;
+		return *this;
+	}
+
+	Quadric operator+(const Quadric& o) const
+	{
+		Quadric t(*this);
+		return t += o;
+	}
+
+	// 点 p における誤差 (平面までの距離の二乗の重み付き平均)
+	GLdouble error(const GLfloat* p) const
+	{
+		const GLdouble x(p[0]), y(p[1]), z(p[2]);
+		const GLdouble e(
+			q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x +
+			q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y +
+			q[7] * z * z + 2.0 * q[8] * z +
+			q[9]);
+
+		return e > 0.0 && weight > 0.0 ? e / weight : 0.0;
+	}
+};
+
+/*
+ * @brief 点から三角形までの距離の二乗
+ * @param p:       点
+ * @param a, b, c: 三角形の頂点
+ */
+inline GLdouble pointTriangleDistance2(const GLfloat* p, const GLfloat* a, const GLfloat* b, const GLfloat* c)
+{
+	GLdouble ab[3], ac[3], ap[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		ab[k] = b[k] - a[k];
+		ac[k] = c[k] - a[k];
+		ap[k] = p[k] - a[k];
+	}
+	const auto dot([](const GLdouble* x, const GLdouble* y) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; });
+
+	// 面の上の最近点
+	const GLdouble d00(dot(ab, ab)), d01(dot(ab, ac)), d11(dot(ac, ac));
+	const GLdouble d20(dot(ap, ab)), d21(dot(ap, ac));
+	const GLdouble det(d00 * d11 - d01 * d01);
+	if (det > 0.0)
+	{
+		const GLdouble s((d11 * d20 - d01 * d21) / det), t((d00 * d21 - d01 * d20) / det);
+		if (s >= 0.0 && t >= 0.0 && s + t <= 1.0)
+		{
+			GLdouble q[3];
+			for (int k = 0; k < 3; ++k) q[k] = ap[k] - ab[k] * s - ac[k] * t;
+			return dot(q, q);
+		}
+	}
+
+	// 面の外なら 3 本の辺の最近点のうち最も近いもの
+	GLdouble best(HUGE_VAL);
+	const GLfloat* const edge[][2] = { { a, b }, { b, c }, { c, a } };
+	for (const auto& e : edge)
+	{
+		GLdouble d[3], q[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			d[k] = e[1][k] - e[0][k];
+			q[k] = p[k] - e[0][k];
+		}
+		const GLdouble l(dot(d, d));
+		const GLdouble u(l > 0.0 ? std::min(std::max(dot(q, d) / l, 0.0), 1.0) : 0.0);
+		for (int k = 0; k < 3; ++k) q[k] -= d[k] * u;
+		best = std::min(best, dot(q, q));
+	}
+
+	return best;
+}
+
+/*
+ * @brief 元の形状の頂点から間引いた面までの距離の最大値を求める
+ *        間引いた三角形を一様な格子に登録して、近い格子から順に調べる
+ * @param vertex:     頂点属性を格納した配列
+ * @param index:      元の三角形のインデックス
+ * @param indexcount: 元のインデックスの要素数
+ * @param lod:        間引いたインデックス
+ * @return            距離の最大値 (モデル座標系)
+ */
+inline GLfloat surfaceDistance(
+	const Object::Vertex* vertex,
+	const GLuint* index,
+	GLsizei indexcount,
+	const std::vector<GLuint>& lod)
+{
+	if (indexcount < 3) return 0.f;
+	if (lod.size() < 3) return HUGE_VALF;
+
+	// 間引いた三角形を囲む箱と格子の大きさ
+	const std::size_t triangles(lod.size() / 3);
+	GLdouble lo[3], hi[3];
+	for (int k = 0; k < 3; ++k) lo[k] = hi[k] = vertex[lod[0]].position[k];
+	for (const GLuint i : lod)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			lo[k] = std::min(lo[k], static_cast<GLdouble>(vertex[i].position[k]));
+			hi[k] = std::max(hi[k], static_cast<GLdouble>(vertex[i].position[k]));
+		}
+	}
+	const int n(std::min(std::max(static_cast<int>(std::cbrt(static_cast<double>(triangles))), 1), 64));
+	GLdouble size[3];
+	for (int k = 0; k < 3; ++k) size[k] = std::max((hi[k] - lo[k]) / n, 1e-12);
+
+	const auto cellOf([&](GLdouble x, int k)
+	{
+		return std::min(std::max(static_cast<int>((x - lo[k]) / size[k]), 0), n - 1);
+	});
+
+	// 格子ごとの三角形のリスト (三角形を囲む箱が重なる格子の全てに登録する)
+	std::vector<std::vector<GLuint>> cell(n * n * n);
+	for (std::size_t t = 0; t < triangles; ++t)
+	{
+		int c0[3], c1[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			GLdouble a(vertex[lod[t * 3]].position[k]), b(a);
+			for (int v = 1; v < 3; ++v)
+			{
+				a = std::min(a, static_cast<GLdouble>(vertex[lod[t * 3 + v]].position[k]));
+				b = std::max(b, static_cast<GLdouble>(vertex[lod[t * 3 + v]].position[k]));
+			}
+			c0[k] = cellOf(a, k);
+			c1[k] = cellOf(b, k);
+		}
+		for (int z = c0[2]; z <= c1[2]; ++z)
+			for (int y = c0[1]; y <= c1[1]; ++y)
+				for (int x = c0[0]; x <= c1[0]; ++x) cell[(z * n + y) * n + x].push_back(static_cast<GLuint>(t));
+	}
+
+	std::vector<bool> used(*std::max_element(index, index + indexcount) + 1, false);
+	std::vector<GLuint> seen(triangles, 0);
+	GLuint stamp(0);
+	GLdouble worst(0.0);
+
+	for (GLsizei i = 0; i < indexcount; ++i)
+	{
+		if (used[index[i]]) continue;
+		used[index[i]] = true;
+
+		const GLfloat* const p(vertex[index[i]].position);
+		int c[3];
+		for (int k = 0; k < 3; ++k) c[k] = cellOf(p[k], k);
+
+		// 調べた格子の外にある三角形までの距離が最短距離を超えたら打ち切る
+		++stamp;
+		GLdouble best(HUGE_VAL);
+		for (int r = 0;; ++r)
+		{
+			for (int z = std::max(c[2] - r, 0); z <= std::min(c[2] + r, n - 1); ++z)
+			{
+				for (int y = std::max(c[1] - r, 0); y <= std::min(c[1] + r, n - 1); ++y)
+				{
+					for (int x = std::max(c[0] - r, 0); x <= std::min(c[0] + r, n - 1); ++x)
+					{
+						// 前の半径で調べた格子は飛ばす
+						if (std::abs(x - c[0]) < r && std::abs(y - c[1]) < r && std::abs(z - c[2]) < r) continue;
+
+						for (const GLuint t : cell[(z * n + y) * n + x])
+						{
+							if (seen[t] == stamp) continue;
+							seen[t] = stamp;
+							best = std::min(best, pointTriangleDistance2(p,
+								vertex[lod[t * 3]].position, vertex[lod[t * 3 + 1]].position, vertex[lod[t * 3 + 2]].position));
+						}
+					}
+				}
+			}
+
+			GLdouble bound(HUGE_VAL);
+			for (int k = 0; k < 3; ++k)
+			{
+				if (c[k] - r > 0) bound = std::min(bound, p[k] - (lo[k] + (c[k] - r) * size[k]));
+				if (c[k] + r < n - 1) bound = std::min(bound, lo[k] + (c[k] + r + 1) * size[k] - p[k]);
+			}
+			if (bound == HUGE_VAL || (bound > 0.0 && best <= bound * bound)) break;
+		}
+
+		worst = std::max(worst, best);
+	}
+
+	return static_cast<GLfloat>(sqrt(worst));
+}
+
+/*
+ * @brief 頂点を移動せずに辺を縮約してインデックスを間引く
+ *        頂点バッファは共有したまま LOD 用のインデックスだけを作る
+ * @param vertex:      頂点属性を格納した配列
+ * @param vertexcount: 頂点の数
+ * @param index:       三角形のインデックスを格納した配列
+ * @param indexcount:  インデックスの要素数
+ * @param target:      目標とするインデックスの要素数
+ * @param result:      間引いたインデックス
+ * @return             元の頂点から間引いた面までの距離の最大値 (surfaceDistance() で測る)
+ */
+inline GLfloat simplify(
+	const Object::Vertex* vertex,
+	GLsizei vertexcount,
+	const GLuint* index,
+	GLsizei indexcount,
+	GLsizei target,
+	std::vector<GLuint>& result)
+{
+	result.assign(index, index + indexcount - indexcount % 3);
+
+	// 位置が同じで法線が異なる頂点 (シーム) は動かすと割れるので固定する
+	struct Key
+	{
+		GLfloat p[3];
+		bool operator==(const Key& o) const
+		{
+			return p[0] == o.p[0] && p[1] == o.p[1] && p[2] == o.p[2];
+		}
+	};
+	struct Hash
+	{
+		std::size_t operator()(const Key& k) const
+		{
+			const std::hash<GLfloat> hash;
+			return (hash(k.p[0]) * 31 + hash(k.p[1])) * 31 + hash(k.p[2]);
+		}
+	};
+
+	std::vector<bool> locked(vertexcount, false);
+	{
+		std::unordered_map<Key, GLuint, Hash> first;
+		for (GLsizei i = 0; i < vertexcount; ++i)
+		{
+			const Key k{ { vertex[i].position[0], vertex[i].position[1], vertex[i].position[2] } };
+			const auto r(first.insert(std::make_pair(k, static_cast<GLuint>(i))));
+			if (!r.second) locked[i] = locked[r.first->second] = true;
+		}
+	}
+
+	// 各頂点に接する面の二次誤差を集める
+	std::vector<Quadric> quadric(vertexcount);
+	std::unordered_map<unsigned long long, int> edgeUse;
+	const auto edgeKey([](GLuint a, GLuint b)
+	{
+		return a < b
+			? static_cast<unsigned long long>(a) << 32 | b
+			: static_cast<unsigned long long>(b) << 32 | a;
+	});
+
+	for (std::size_t t = 0; t < result.size(); t += 3)
+	{
+		const GLfloat* const p0(vertex[result[t + 0]].position);
+		const GLfloat* const p1(vertex[result[t + 1]].position);
+		const GLfloat* const p2(vertex[result[t + 2]].position);
+
+		const GLdouble e1[] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const GLdouble e2[] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		GLdouble n[] =
+		{
+			e1[1] * e2[2] - e1[2] * e2[1],
+			e1[2] * e2[0] - e1[0] * e2[2],
+			e1[0] * e2[1] - e1[1] * e2[0]
+		};
+		const GLdouble l(sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+		if (l == 0.0) continue;
+		n[0] /= l; n[1] /= l; n[2] /= l;
+
+		const Quadric plane(n[0], n[1], n[2], -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]));
+		for (int k = 0; k < 3; ++k)
+		{
+			quadric[result[t + k]] += plane;
+			++edgeUse[edgeKey(result[t + k], result[t + (k + 1) % 3])];
+		}
+	}
+
+	// 境界の辺には面に垂直な平面を加えて輪郭が崩れないようにする
+	for (std::size_t t = 0; t < result.size(); t += 3)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			const GLuint a(result[t + k]), b(result[t + (k + 1) % 3]), c(result[t + (k + 2) % 3]);
+			if (edgeUse[edgeKey(a, b)] != 1) continue;
+
+			const GLfloat* const pa(vertex[a].position);
+			const GLfloat* const pb(vertex[b].position);
+			const GLfloat* const pc(vertex[c].position);
+			const GLdouble e[] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+			const GLdouble f[] = { pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2] };
+			const GLdouble ee(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+			if (ee == 0.0) continue;
+
+			// 辺に垂直で面内にある方向
+			const GLdouble s((f[0] * e[0] + f[1] * e[1] + f[2] * e[2]) / ee);
+			GLdouble n[] = { f[0] - s * e[0], f[1] - s * e[1], f[2] - s * e[2] };
+			const GLdouble l(sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+			if (l == 0.0) continue;
+			n[0] /= l; n[1] /= l; n[2] /= l;
+
+			const Quadric border(n[0], n[1], n[2], -(n[0] * pa[0] + n[1] * pa[1] + n[2] * pa[2]), 10.0);
+			quadric[a] += border;
+			quadric[b] += border;
+		}
+	}
+
+	std::vector<GLuint> remap(vertexcount);
+
+	// 縮約 u -> v で u に接する三角形が裏返らないか調べる
+	const auto flips([&](GLuint u, GLuint v, const std::vector<GLuint>& faces)
+	{
+		const GLfloat* const pv(vertex[v].position);
+
+		for (const GLuint t : faces)
+		{
+			GLuint i[] = { result[t], result[t + 1], result[t + 2] };
+			if (i[0] == v || i[1] == v || i[2] == v) continue;
+
+			const GLfloat* p[3];
+			const GLfloat* q[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				p[k] = vertex[i[k]].position;
+				q[k] = i[k] == u ? pv : p[k];
+			}
+
+			GLdouble n0[3], n1[3];
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				const GLfloat* const* const r(pass == 0 ? p : q);
+				GLdouble* const n(pass == 0 ? n0 : n1);
+				const GLdouble e1[] = { r[1][0] - r[0][0], r[1][1] - r[0][1], r[1][2] - r[0][2] };
+				const GLdouble e2[] = { r[2][0] - r[0][0], r[2][1] - r[0][1], r[2][2] - r[0][2] };
+				n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+				n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+				n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+			}
+
+			if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0) return true;
+		}
+
+		return false;
+	});
+
+	struct Collapse
+	{
+		GLuint u, v;
+		GLdouble error;
+	};
+
+	// 1 パスごとに誤差の小さい辺から互いに独立なものだけを縮約する
+	while (static_cast<GLsizei>(result.size()) > target)
+	{
+		std::vector<std::vector<GLuint>> faces(vertexcount);
+		for (std::size_t t = 0; t < result.size(); t += 3)
+			for (int k = 0; k < 3; ++k) faces[result[t + k]].push_back(static_cast<GLuint>(t));
+
+		std::vector<Collapse> collapse;
+		collapse.reserve(result.size());
+		for (std::size_t t = 0; t < result.size(); t += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				const GLuint a(result[t + k]), b(result[t + (k + 1) % 3]);
+				const Quadric q(quadric[a] + quadric[b]);
+				const GLdouble ea(locked[a] ? HUGE_VAL : q.error(vertex[b].position));
+				const GLdouble eb(locked[b] ? HUGE_VAL : q.error(vertex[a].position));
+				if (ea == HUGE_VAL && eb == HUGE_VAL) continue;
+
+				collapse.push_back(ea <= eb ? Collapse{ a, b, ea } : Collapse{ b, a, eb });
+			}
+		}
+		if (collapse.empty()) break;
+
+		std::sort(collapse.begin(), collapse.end(), [](const Collapse& x, const Collapse& y)
+		{
+			return x.error < y.error;
+		});
+
+		for (GLsizei i = 0; i < vertexcount; ++i) remap[i] = i;
+		std::vector<bool> touched(vertexcount, false);
+
+		// 1 回の縮約でおよそ 2 枚の三角形が消える
+		std::size_t limit((result.size() - target) / 6 + 1);
+		std::size_t done(0);
+
+		for (const Collapse& c : collapse)
+		{
+			if (done >= limit) break;
+			if (touched[c.u] || touched[c.v]) continue;
+			if (flips(c.u, c.v, faces[c.u])) continue;
+
+			remap[c.u] = c.v;
+			quadric[c.v] += quadric[c.u];
+
+			for (const GLuint t : faces[c.u])
+				for (int k = 0; k < 3; ++k) touched[result[t + k]] = true;
+			++done;
+		}
+		if (done == 0) break;
+
+		// 縮退した三角形を取り除く
+		std::size_t n(0);
+		for (std::size_t t = 0; t < result.size(); t += 3)
+		{
+			const GLuint a(remap[result[t]]), b(remap[result[t + 1]]), c(remap[result[t + 2]]);
+			if (a == b || b == c || c == a) continue;
+
+			result[n++] = a;
+			result[n++] = b;
+			result[n++] = c;
+		}
+		result.resize(n);
+	}
+
+	// 二次誤差は平面までの距離の平均なので、実際の距離の最大値はそれより大きくなりうる
+	return surfaceDistance(vertex, index, indexcount - indexcount % 3, result);
+}
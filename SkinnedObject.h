@@ -0,0 +1,110 @@
+#pragma once
+#include <iostream>
+#include <GL/glew.h>
+#include "Object.h"
+
+// 関節の番号と重みを持つ頂点配列オブジェクト (skin.vert で描く)
+class SkinnedObject
+{
+private:
+	GLuint vao;
+	GLuint vbo;
+	GLuint ibo;
+
+	// インデックスの型
+	GLenum type;
+
+public:
+	// Object::Vertex に関節の番号と重みを加えたもの
+	struct Vertex
+	{
+		GLfloat position[3];
+		GLfloat normal[3];
+		GLubyte joint[4];
+		GLfloat weight[4];
+	};
+
+	// 関節の数の上限 (skin.vert の uniform 変数 joint の要素数と同じにすること)
+	static constexpr GLsizei maxJoints = 64;
+
+	/*
+	 * @brief 頂点の関節の番号が上限を超えていないか調べる
+	 * @param vertexcount: 頂点の数
+	 * @param vertex:      頂点属性を格納した配列
+	 * @return             重みのある関節の番号がすべて maxJoints 未満なら true
+	 */
+	static bool checkJoints(GLsizei vertexcount, const Vertex* vertex)
+	{
+		for (GLsizei i = 0; i < vertexcount; ++i)
+		{
+			for (int k = 0; k < 4; ++k)
+			{
+				if (vertex[i].weight[k] != 0.f && vertex[i].joint[k] >= maxJoints)
+				{
+					std::cerr << "Error: Joint index " << static_cast<int>(vertex[i].joint[k])
+						<< " exceeds the limit of " << maxJoints << " joints" << std::endl;
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// size: 頂点の位置の次元
+	// vertexcount: 頂点の数
+	// vertex: 頂点属性を格納した配列
+	// indexcount: 頂点のインデックスの要素数
+	// index: 頂点のインデックスを格納した配列
+	SkinnedObject(
+		GLint size,
+		GLsizei vertexcount,
+		const Vertex* vertex,
+		GLsizei indexcount,
+		const GLuint* index)
+	 : type(Object::selectIndexType(vertexcount))
+	{
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertexcount * sizeof(Vertex), vertex, GL_STATIC_DRAW);
+
+		glVertexAttribPointer(0, size, GL_FLOAT, GL_FALSE, sizeof(Vertex), static_cast<Vertex*>(0)->position);
+		glEnableVertexAttribArray(0);
+
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), static_cast<Vertex*>(0)->normal);
+		glEnableVertexAttribArray(1);
+
+		glVertexAttribIPointer(2, 4, GL_UNSIGNED_BYTE, sizeof(Vertex), static_cast<Vertex*>(0)->joint);
+		glEnableVertexAttribArray(2);
+
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), static_cast<Vertex*>(0)->weight);
+		glEnableVertexAttribArray(3);
+
+		glGenBuffers(1, &ibo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+		Object::uploadIndex(type, vertexcount, indexcount, index);
+	}
+
+	virtual ~SkinnedObject()
+	{
+		Object::retire(vao, vbo, ibo);
+	}
+
+private:
+	SkinnedObject(const SkinnedObject &o);
+	SkinnedObject &operator=(const SkinnedObject &o);
+
+public:
+	void bind() const
+	{
+		glBindVertexArray(vao);
+	}
+
+	GLenum getIndexType() const
+	{
+		return type;
+	}
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "Matrix.h"
+#include "SkinnedObject.h"
+
+// スキニングする三角形の形状
+class SkinnedShape
+{
+	std::shared_ptr<const SkinnedObject> object;
+
+protected:
+	const GLsizei indexcount;
+	const GLenum indexType;
+
+public:
+	// 関節の番号が SkinnedObject::maxJoints 以上の頂点があれば何も描かない
+	SkinnedShape(
+		GLint size,
+		GLsizei vertexcount,
+		const SkinnedObject::Vertex* vertex,
+		GLsizei indexcount,
+		const GLuint* index)
+	 : object(new SkinnedObject(size, vertexcount, vertex, indexcount, index)),
+	   indexcount(SkinnedObject::checkJoints(vertexcount, vertex) ? indexcount : 0),
+	   indexType(object->getIndexType())
+	{}
+
+	/*
+	 * @brief 関節の変換行列を設定して描画する
+	 * @param jointLoc: skin.vert の uniform 変数 joint の場所
+	 * @param skin:     関節ごとの変換行列 (Character::skin、SkinnedObject::maxJoints 個まで送る)
+	 */
+	void draw(GLint jointLoc, const std::vector<Matrix>& skin) const
+	{
+		if (skin.empty()) return;
+
+		// 頂点は maxJoints 未満の関節しか参照しないので、それを超える分は送らない
+		const GLsizei joints(std::min(static_cast<GLsizei>(skin.size()), SkinnedObject::maxJoints));
+		glUniformMatrix4fv(jointLoc, joints, GL_FALSE, skin.front().data());
+		object->bind();
+		execute();
+	}
+
+	virtual void execute() const
+	{
+		glDrawElements(GL_TRIANGLES, indexcount, indexType, 0);
+	}
+
+};
@@ -11,7 +11,7 @@ public:
 
 	virtual void execute() const
 	{
-		glDrawElements(GL_TRIANGLES, indexcount, GL_UNSIGNED_INT, 0);
+		glDrawElements(GL_TRIANGLES, indexcount, indexType, 0);
 	}
 
 };
@@ -0,0 +1,138 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "Shape.h"
+#include "Simplify.h"
+
+class SolidShapeLod : public Shape
+{
+public:
+	struct Level
+	{
+		GLsizei first;  // インデックスバッファ内の先頭位置
+		GLsizei count;  // インデックスの要素数
+		GLfloat error;  // 元の頂点から面までの距離の最大値 (モデル座標系、前の段以上)
+	};
+
+private:
+	struct Chain
+	{
+		std::vector<GLuint> index;
+		std::vector<Level> level;
+	};
+
+	const std::vector<Level> level;
+	GLfloat center[3];
+	GLfloat radius;
+
+	/*
+	 * @brief 間引いたインデックスを順に連結して 1 つのインデックスバッファにする
+	 * @param levels: 作成する LOD の最大段数 (元の形状を含む)
+	 * @param ratio:  1 段ごとの三角形の削減率
+	 */
+	static Chain makeChain(
+		GLsizei vertexcount,
+		const Object::Vertex* vertex,
+		GLsizei indexcount,
+		const GLuint* index,
+		GLsizei levels,
+		GLfloat ratio)
+	{
+		Chain chain;
+		chain.index.assign(index, index + indexcount);
+		chain.level.push_back(Level{ 0, indexcount, 0.f });
+
+		std::vector<GLuint> lod;
+		for (GLsizei i = 1; i < levels; ++i)
+		{
+			const Level& prev(chain.level.back());
+			const GLsizei target(static_cast<GLsizei>(prev.count / 3 * ratio) * 3);
+			if (target < 3) break;
+
+			const GLfloat error(simplify(vertex, vertexcount, index, indexcount, target, lod));
+
+			// ほとんど減らなければそれ以上の段は作らない
+			if (static_cast<GLfloat>(lod.size()) > prev.count * 0.9f) break;
+
+			chain.level.push_back(Level{
+				static_cast<GLsizei>(chain.index.size()),
+				static_cast<GLsizei>(lod.size()),
+				std::max(error, prev.error) });
+			chain.index.insert(chain.index.end(), lod.begin(), lod.end());
+		}
+
+		return chain;
+	}
+
+	SolidShapeLod(GLint size, GLsizei vertexcount, const Object::Vertex* vertex, const Chain& chain)
+	 : Shape(size, vertexcount, vertex, static_cast<GLsizei>(chain.index.size()), chain.index.data()),
+	   level(chain.level)
+	{
+		// 包含球
+		GLfloat lo[3], hi[3];
+		for (int k = 0; k < 3; ++k) lo[k] = hi[k] = vertexcount > 0 ? vertex[0].position[k] : 0.f;
+		for (GLsizei i = 1; i < vertexcount; ++i)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				lo[k] = std::min(lo[k], vertex[i].position[k]);
+				hi[k] = std::max(hi[k], vertex[i].position[k]);
+			}
+		}
+		for (int k = 0; k < 3; ++k) center[k] = (lo[k] + hi[k]) * 0.5f;
+
+		GLfloat r2(0.f);
+		for (GLsizei i = 0; i < vertexcount; ++i)
+		{
+			const GLfloat dx(vertex[i].position[0] - center[0]);
+			const GLfloat dy(vertex[i].position[1] - center[1]);
+			const GLfloat dz(vertex[i].position[2] - center[2]);
+			r2 = std::max(r2, dx * dx + dy * dy + dz * dz);
+		}
+		radius = sqrt(r2);
+	}
+
+public:
+	// levels: 作成する LOD の最大段数 (元の形状を含む)
+	// ratio: 1 段ごとの三角形の削減率
+	SolidShapeLod(
+		GLint size,
+		GLsizei vertexcount,
+		const Object::Vertex* vertex,
+		GLsizei indexcount,
+		const GLuint* index,
+		GLsizei levels = 4,
+		GLfloat ratio = 0.5f)
+	 : SolidShapeLod(size, vertexcount, vertex, makeChain(vertexcount, vertex, indexcount, index, levels, ratio))
+	{}
+
+	using Shape::draw;
+
+	// 指定した段の LOD を描画する
+	void draw(GLsizei lod) const
+	{
+		bind();
+		execute(lod);
+	}
+
+	virtual void execute() const
+	{
+		execute(0);
+	}
+
+	void execute(GLsizei lod) const
+	{
+		const Level& l(level[std::min(std::max(lod, 0), getLevelCount() - 1)]);
+		glDrawElements(GL_TRIANGLES, l.count, indexType, static_cast<const GLubyte*>(0) + l.first * Object::getIndexSize(indexType));
+	}
+
+	GLsizei getLevelCount() const { return static_cast<GLsizei>(level.size()); }
+
+	const Level& getLevel(GLsizei lod) const { return level[lod]; }
+
+	const GLfloat* getCenter() const { return center; }
+
+	GLfloat getRadius() const { return radius; }
+
+};
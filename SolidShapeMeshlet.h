@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include "Shape.h"
+#include "Meshlet.h"
+
+// メッシュレットに分けて見えるものだけを描く三角形の形状
+class SolidShapeMeshlet : public Shape
+{
+	struct Build
+	{
+		std::vector<GLuint> index;
+		std::vector<Meshlet> meshlet;
+	};
+
+	const std::vector<Meshlet> meshlet;
+	const std::vector<GLuint> index; // メッシュレットの順に並べ替えたインデックス
+	const GLsizei indexcount;
+
+	static Build makeBuild(
+		GLsizei vertexcount,
+		const Object::Vertex* vertex,
+		GLsizei indexcount,
+		const GLuint* index,
+		GLsizei maxVertices,
+		GLsizei maxTriangles)
+	{
+		Build build;
+		buildMeshlets(vertex, vertexcount, index, indexcount, build.index, build.meshlet, maxVertices, maxTriangles);
+		return build;
+	}
+
+	SolidShapeMeshlet(GLint size, GLsizei vertexcount, const Object::Vertex* vertex, const Build& build)
+	 : Shape(size, vertexcount, vertex, static_cast<GLsizei>(build.index.size()), build.index.data()),
+	   meshlet(build.meshlet),
+	   index(build.index),
+	   indexcount(static_cast<GLsizei>(build.index.size()))
+	{}
+
+public:
+	// maxVertices: 1 つのメッシュレットの頂点の最大数
+	// maxTriangles: 1 つのメッシュレットの三角形の最大数
+	SolidShapeMeshlet(
+		GLint size,
+		GLsizei vertexcount,
+		const Object::Vertex* vertex,
+		GLsizei indexcount,
+		const GLuint* index,
+		GLsizei maxVertices = 64,
+		GLsizei maxTriangles = 124)
+	 : SolidShapeMeshlet(size, vertexcount, vertex, makeBuild(vertexcount, vertex, indexcount, index, maxVertices, maxTriangles))
+	{}
+
+	using Shape::draw;
+
+	/*
+	 * @brief 見えるメッシュレットだけを描く
+	 * @param culler:     間引きの結果と統計を置くところ
+	 * @param modelview:  モデルビュー変換行列
+	 * @param projection: 投影変換行列
+	 */
+	void draw(MeshletCuller& culler, const Matrix& modelview, const Matrix& projection) const
+	{
+		culler.cull(meshlet, modelview, projection, Object::getIndexSize(indexType));
+		if (culler.getRangeCount() == 0) return;
+
+		bind();
+		glMultiDrawElements(GL_TRIANGLES, culler.getCount(), indexType, culler.getOffset(), culler.getRangeCount());
+	}
+
+	virtual void execute() const
+	{
+		glDrawElements(GL_TRIANGLES, indexcount, indexType, 0);
+	}
+
+	const std::vector<Meshlet>& getMeshlets() const { return meshlet; }
+
+	// 描画に使うインデックス (MeshletCuller の範囲はこの並びの位置を指す)
+	const std::vector<GLuint>& getIndex() const { return index; }
+
+};
@@ -0,0 +1,835 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <GL/glew.h>
+#include "Object.h"
+#include "Shape.h"
+#include "Program.h"
+
+// トレースファイルのヘッダ
+struct TraceHeader
+{
+	char magic[4];   // "TRCE"
+	GLuint version;  // 書式の版
+};
+
+// トレースのコマンド
+// 各コマンドはコマンド番号と引数のバイト数に続けて引数を置く
+enum TraceOp : GLuint
+{
+	TraceProgram = 1, // handle, 2 つのソースの長さ, バーテックスシェーダ, フラグメントシェーダ
+	TraceUniformName, // program, location, 名前
+	TraceMesh,        // handle, mode, size, vertexcount, indexcount, 頂点, インデックス
+	TraceFrame,       // 時刻
+	TraceInput,       // size[2], scale, location[2]
+	TraceUseProgram,  // handle
+	TraceUniform,     // location, type, 値
+	TraceEnable,      // cap, 有効なら 1
+	TraceClear,       // mask
+	TraceDraw,        // handle
+	TracePresent,     // フレームの終わり
+	TraceDrawRanges   // handle, 範囲の数, 範囲ごとの先頭のインデックスの位置と数
+};
+
+// 描画コマンドを記録してファイルに書き出す
+// 描画スレッドはメモリ上のバッファに書き込むだけで、ファイルへの書き出しは別スレッドで行う
+class TraceRecorder
+{
+	std::ofstream file;
+
+	// 描画スレッドが書き込んでいるバッファ
+	std::vector<char> buffer;
+
+	// 書き出し待ちのバッファと書き出し終えて再利用するバッファ
+	std::deque<std::vector<char>> queue;
+	std::vector<std::vector<char>> spare;
+
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool quit;
+
+	// これだけたまったら書き出しに回す
+	const std::size_t flushSize;
+
+	// 書き込み中のコマンドの引数のバイト数を置く位置
+	std::size_t command;
+
+	std::size_t frames;
+	std::size_t bytes;
+
+public:
+	// name: トレースファイル名
+	// flushSize: 書き出しに回すバッファの大きさ
+	TraceRecorder(const char* name, std::size_t flushSize = 256 << 10)
+	 : file(name, std::ios::binary),
+	   quit(false),
+	   flushSize(flushSize),
+	   command(0),
+	   frames(0),
+	   bytes(0)
+	{
+		if (file.fail())
+		{
+			std::cerr << "Error: Can't open trace file: " << name << std::endl;
+			return;
+		}
+
+		const TraceHeader header{ { 'T', 'R', 'C', 'E' }, 1 };
+		file.write(reinterpret_cast<const char*>(&header), sizeof header);
+
+		buffer.reserve(flushSize * 2);
+		writer = std::thread(&TraceRecorder::write, this);
+	}
+
+	virtual ~TraceRecorder()
+	{
+		if (!writer.joinable()) return;
+
+		flush();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		condition.notify_one();
+		writer.join();
+	}
+
+private:
+	TraceRecorder(const TraceRecorder &o);
+	TraceRecorder &operator=(const TraceRecorder &o);
+
+	void write()
+	{
+		for (;;)
+		{
+			std::vector<char> data;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return quit || !queue.empty(); });
+				if (queue.empty()) return;
+
+				data.swap(queue.front());
+				queue.pop_front();
+			}
+
+			file.write(data.data(), data.size());
+			data.clear();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			spare.push_back(std::move(data));
+		}
+	}
+
+	// たまったコマンドを書き出しに回す
+	void flush()
+	{
+		if (buffer.empty()) return;
+		bytes += buffer.size();
+
+		std::vector<char> next;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(std::move(buffer));
+			if (!spare.empty())
+			{
+				next.swap(spare.back());
+				spare.pop_back();
+			}
+		}
+		condition.notify_one();
+
+		buffer.swap(next);
+		buffer.reserve(flushSize * 2);
+	}
+
+	void put(const void* data, std::size_t size)
+	{
+		const char* const p(static_cast<const char*>(data));
+		buffer.insert(buffer.end(), p, p + size);
+	}
+
+	template <typename T>
+	void put(const T& value)
+	{
+		put(&value, sizeof value);
+	}
+
+	void begin(TraceOp op)
+	{
+		put(static_cast<GLuint>(op));
+		command = buffer.size();
+		put(GLuint(0));
+	}
+
+	void end()
+	{
+		const GLuint size(static_cast<GLuint>(buffer.size() - command - sizeof(GLuint)));
+		memcpy(&buffer[command], &size, sizeof size);
+	}
+
+public:
+	bool isOpen() const
+	{
+		return writer.joinable();
+	}
+
+	/*
+	 * @brief プログラムオブジェクトを登録する
+	 * @param handle: 以降のコマンドでこのプログラムを指す番号
+	 * @param vsrc:   バーテックスシェーダのソースプログラム
+	 * @param fsrc:   フラグメントシェーダのソースプログラム
+	 */
+	void program(GLuint handle, const char* vsrc, const char* fsrc)
+	{
+		const GLuint vlength(static_cast<GLuint>(strlen(vsrc))), flength(static_cast<GLuint>(strlen(fsrc)));
+		begin(TraceProgram);
+		put(handle);
+		put(vlength);
+		put(flength);
+		put(vsrc, vlength);
+		put(fsrc, flength);
+		end();
+	}
+
+	/*
+	 * @brief uniform 変数の場所と名前の対応を登録する
+	 *        再生時には名前から場所を求め直す
+	 * @param program:  プログラムの番号
+	 * @param location: 記録時の uniform 変数の場所
+	 * @param name:     uniform 変数の名前
+	 */
+	void uniformName(GLuint program, GLint location, const char* name)
+	{
+		begin(TraceUniformName);
+		put(program);
+		put(location);
+		put(name, strlen(name));
+		end();
+	}
+
+	/*
+	 * @brief 形状を登録する
+	 * @param handle: 以降のコマンドでこの形状を指す番号
+	 * @param mode:   基本図形 (GL_LINE_LOOP, GL_LINES, GL_TRIANGLES)
+	 * 他の引数は Shape と同じ (indexcount が 0 ならインデックスを使わない)
+	 */
+	void mesh(GLuint handle, GLenum mode, GLint size,
+		GLsizei vertexcount, const Object::Vertex* vertex,
+		GLsizei indexcount = 0, const GLuint* index = NULL)
+	{
+		begin(TraceMesh);
+		put(handle);
+		put(mode);
+		put(size);
+		put(vertexcount);
+		put(indexcount);
+		put(vertex, vertexcount * sizeof(Object::Vertex));
+		if (indexcount > 0) put(index, indexcount * sizeof(GLuint));
+		end();
+	}
+
+	// フレームの始まりと時刻
+	void frame(double time)
+	{
+		begin(TraceFrame);
+		put(time);
+		end();
+	}
+
+	// ウィンドウの大きさと入力
+	void input(const GLfloat* size, GLfloat scale, const GLfloat* location)
+	{
+		begin(TraceInput);
+		put(size, 2 * sizeof(GLfloat));
+		put(scale);
+		put(location, 2 * sizeof(GLfloat));
+		end();
+	}
+
+	void useProgram(GLuint handle)
+	{
+		begin(TraceUseProgram);
+		put(handle);
+		end();
+	}
+
+	/*
+	 * @brief uniform 変数の設定を記録する
+	 * @param location: uniform 変数の場所
+	 * @param type:     GL_FLOAT, GL_FLOAT_VEC2〜4, GL_FLOAT_MAT3, GL_FLOAT_MAT4 のいずれか
+	 * @param value:    値
+	 */
+	void uniform(GLint location, GLenum type, const GLfloat* value)
+	{
+		begin(TraceUniform);
+		put(location);
+		put(type);
+		put(value, uniformSize(type) * sizeof(GLfloat));
+		end();
+	}
+
+	void enable(GLenum cap, bool flag = true)
+	{
+		begin(TraceEnable);
+		put(cap);
+		put(GLuint(flag ? 1 : 0));
+		end();
+	}
+
+	void clear(GLbitfield mask)
+	{
+		begin(TraceClear);
+		put(mask);
+		end();
+	}
+
+	void draw(GLuint handle)
+	{
+		begin(TraceDraw);
+		put(handle);
+		end();
+	}
+
+	/*
+	 * @brief インデックスの一部の範囲だけを描いたことを記録する
+	 *        カリングで間引いたときのように実際に描いた範囲を残す
+	 * @param handle: 形状の番号
+	 * @param ranges: 範囲の数
+	 * @param first:  範囲ごとの先頭のインデックスの位置 (要素単位)
+	 * @param count:  範囲ごとのインデックスの数
+	 */
+	void drawRanges(GLuint handle, GLsizei ranges, const GLuint* first, const GLsizei* count)
+	{
+		begin(TraceDrawRanges);
+		put(handle);
+		put(ranges);
+		for (GLsizei i = 0; i < ranges; ++i)
+		{
+			put(first[i]);
+			put(count[i]);
+		}
+		end();
+	}
+
+	// フレームの終わり
+	void present()
+	{
+		begin(TracePresent);
+		end();
+
+		++frames;
+		if (buffer.size() >= flushSize) flush();
+	}
+
+	std::size_t getFrameCount() const { return frames; }
+
+	// 書き出しに回したバイト数
+	std::size_t getByteCount() const { return bytes; }
+
+	// uniform 変数の型の要素数
+	static GLsizei uniformSize(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_FLOAT: return 1;
+		case GL_FLOAT_VEC2: return 2;
+		case GL_FLOAT_VEC3: return 3;
+		case GL_FLOAT_VEC4: return 4;
+		case GL_FLOAT_MAT3: return 9;
+		case GL_FLOAT_MAT4: return 16;
+		}
+		return 0;
+	}
+};
+
+// 記録した形状を記録時の基本図形で描く
+class TraceShape : public Shape
+{
+	const GLenum mode;
+	const GLsizei count;  // 描く頂点またはインデックスの数
+	const bool indexed;   // インデックスを使うか
+
+public:
+	// mode: 基本図形
+	// 他の引数は Shape と同じ (indexcount が 0 ならインデックスを使わない)
+	TraceShape(GLenum mode, GLint size,
+		GLsizei vertexcount, const Object::Vertex* vertex,
+		GLsizei indexcount, const GLuint* index)
+	 : Shape(size, vertexcount, vertex, indexcount, index),
+	   mode(mode),
+	   count(indexcount > 0 ? indexcount : vertexcount),
+	   indexed(indexcount > 0)
+	{}
+
+	using Shape::draw;
+
+	/*
+	 * @brief インデックスの一部の範囲だけを描く
+	 * @param ranges: 範囲の数
+	 * @param count:  範囲ごとのインデックスの数
+	 * @param offset: 範囲ごとのインデックスバッファ内の位置 (バイト単位)
+	 */
+	void draw(GLsizei ranges, const GLsizei* count, const GLvoid* const* offset) const
+	{
+		if (!indexed || ranges <= 0) return;
+
+		bind();
+		glMultiDrawElements(mode, count, indexType, offset, ranges);
+	}
+
+	virtual void execute() const
+	{
+		if (indexed)
+			glDrawElements(mode, count, indexType, 0);
+		else
+			glDrawArrays(mode, 0, count);
+	}
+
+	// 描く頂点またはインデックスの数
+	GLsizei getCount() const { return count; }
+
+	// インデックスの 1 要素のバイト数
+	GLsizei getIndexSize() const { return Object::getIndexSize(indexType); }
+};
+
+// トレースファイルを読み込んでコマンドを順に取り出す (GL は呼ばない)
+class TraceReader
+{
+	std::vector<char> data;
+	std::size_t position;
+
+public:
+	TraceReader()
+	 : position(0)
+	{}
+
+	/*
+	 * @brief トレースファイルを読み込む
+	 *        再生中にファイルを読まないように全体をメモリに置く
+	 * @param name: ファイル名
+	 * @return      読み込みに成功すれば true
+	 */
+	bool load(const char* name)
+	{
+		std::ifstream file(name, std::ios::binary);
+		if (file.fail())
+		{
+			std::cerr << "Error: Can't open trace file: " << name << std::endl;
+			return false;
+		}
+
+		TraceHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof header);
+		if (file.fail() || std::string(header.magic, 4) != "TRCE" || header.version != 1)
+		{
+			std::cerr << "Error: Invalid trace file: " << name << std::endl;
+			return false;
+		}
+
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		position = 0;
+		return true;
+	}
+
+	/*
+	 * @brief 次のコマンドを取り出す
+	 * @param op:     コマンド番号
+	 * @param p:      引数の先頭 (境界は揃っていない)
+	 * @param length: 引数のバイト数
+	 * @return        コマンドがあれば true、トレースの終わりなら false
+	 */
+	bool next(GLuint& op, const char*& p, GLuint& length)
+	{
+		if (position + 2 * sizeof(GLuint) <= data.size())
+		{
+			p = &data[position];
+			memcpy(&op, p, sizeof op);
+			memcpy(&length, p + sizeof op, sizeof length);
+			p += 2 * sizeof(GLuint);
+
+			// 書き出しの途中で終わったトレースは最後のコマンドを捨てる
+			if (position + 2 * sizeof(GLuint) + length <= data.size())
+			{
+				position += 2 * sizeof(GLuint) + length;
+				return true;
+			}
+		}
+
+		position = data.size();
+		return false;
+	}
+
+	// 最初のコマンドに戻る
+	void rewind()
+	{
+		position = 0;
+	}
+};
+
+// トレースファイルを読み込んで描画コマンドを再生する
+class TracePlayer
+{
+	TraceReader reader;
+
+	// 記録時の番号から再生用のオブジェクトへの対応
+	std::map<GLuint, GLuint> programs;
+	std::map<GLuint, std::unique_ptr<const TraceShape>> meshes;
+	std::map<std::pair<GLuint, GLint>, std::string> names;
+	std::map<std::pair<GLuint, GLint>, GLint> locations;
+	GLuint current;
+
+	// 範囲を描くときの作業用の配列
+	std::vector<GLsizei> rangeCount;
+	std::vector<const GLvoid*> rangeOffset;
+
+	// 最初のフレームのウィンドウの大きさ
+	GLfloat size[2];
+
+	// フレームバッファとウィンドウの大きさの比 (高解像度のディスプレイでは 1 より大きい)
+	GLfloat framebufferScale[2];
+
+	// 直前に再生したフレームの記録時の時刻
+	double time;
+
+public:
+	TracePlayer()
+	 : current(0),
+	   size{ 640.f, 480.f },
+	   framebufferScale{ 1.f, 1.f },
+	   time(0.0)
+	{}
+
+	virtual ~TracePlayer()
+	{
+		for (const std::pair<const GLuint, GLuint>& p : programs) glDeleteProgram(p.second);
+	}
+
+private:
+	TracePlayer(const TracePlayer &o);
+	TracePlayer &operator=(const TracePlayer &o);
+
+	template <typename T>
+	T get(const char*& p) const
+	{
+		T value;
+		memcpy(&value, p, sizeof value);
+		p += sizeof value;
+		return value;
+	}
+
+	// コマンドの固定長の引数のバイト数
+	static std::size_t argumentSize(GLuint op)
+	{
+		switch (op)
+		{
+		case TraceProgram: return 3 * sizeof(GLuint);
+		case TraceUniformName: return sizeof(GLuint) + sizeof(GLint);
+		case TraceMesh: return 2 * sizeof(GLuint) + sizeof(GLint) + 2 * sizeof(GLsizei);
+		case TraceFrame: return sizeof(double);
+		case TraceInput: return 5 * sizeof(GLfloat);
+		case TraceUseProgram: return sizeof(GLuint);
+		case TraceUniform: return sizeof(GLint) + sizeof(GLenum);
+		case TraceEnable: return sizeof(GLenum) + sizeof(GLuint);
+		case TraceClear: return sizeof(GLbitfield);
+		case TraceDraw: return sizeof(GLuint);
+		case TraceDrawRanges: return sizeof(GLuint) + sizeof(GLsizei);
+		}
+		return 0;
+	}
+
+	// 再生中のプログラムでの uniform 変数の場所
+	GLint locate(GLint location)
+	{
+		const std::pair<GLuint, GLint> key(current, location);
+		const std::map<std::pair<GLuint, GLint>, GLint>::const_iterator found(locations.find(key));
+		if (found != locations.end()) return found->second;
+
+		// 名前が登録されていなければ記録時の場所をそのまま使う
+		const std::map<std::pair<GLuint, GLint>, std::string>::const_iterator name(names.find(key));
+		const GLint l(name == names.end() ? location
+			: glGetUniformLocation(programs[current], name->second.c_str()));
+		locations[key] = l;
+		return l;
+	}
+
+	// 引数の大きさが合わないコマンドを捨てる
+	static void reject(GLuint op)
+	{
+		std::cerr << "Error: Invalid trace command: " << op << std::endl;
+	}
+
+public:
+	/*
+	 * @brief 記録した形状を作ってよいか調べる
+	 * @param mode:        基本図形
+	 * @param dim:         頂点の位置の次元
+	 * @param vertexcount: 頂点の数
+	 * @param indexcount:  インデックスの要素数
+	 * @param index:       インデックス
+	 * @return             基本図形と次元が正しく、インデックスが頂点の範囲内なら true
+	 */
+	static bool checkMesh(GLenum mode, GLint dim, GLsizei vertexcount, GLsizei indexcount, const GLuint* index)
+	{
+		switch (mode)
+		{
+		case GL_POINTS:
+		case GL_LINES:
+		case GL_LINE_LOOP:
+		case GL_LINE_STRIP:
+		case GL_TRIANGLES:
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+			break;
+		default:
+			return false;
+		}
+
+		return dim >= 1 && dim <= 4 && Object::checkIndex(vertexcount, indexcount, index);
+	}
+
+private:
+	// コマンドを 1 つ実行する (length は引数のバイト数)
+	void execute(GLuint op, const char* p, GLuint length)
+	{
+		// 固定長の引数も足りないコマンドは実行しない
+		if (length < argumentSize(op))
+		{
+			reject(op);
+			return;
+		}
+
+		// 固定長の引数に続く可変長の引数のバイト数
+		const std::size_t rest(length - argumentSize(op));
+
+		switch (op)
+		{
+		case TraceProgram:
+		{
+			const GLuint handle(get<GLuint>(p));
+			const GLuint vlength(get<GLuint>(p)), flength(get<GLuint>(p));
+			if (static_cast<std::size_t>(vlength) + flength > rest)
+			{
+				reject(op);
+				break;
+			}
+
+			// 巻き戻して再生するときは作り直さない
+			if (programs.count(handle) > 0) break;
+
+			const std::string vsrc(p, vlength), fsrc(p + vlength, flength);
+			programs[handle] = createProgram(vsrc.c_str(), fsrc.c_str());
+			break;
+		}
+
+		case TraceUniformName:
+		{
+			const GLuint program(get<GLuint>(p));
+			const GLint location(get<GLint>(p));
+			names[std::make_pair(program, location)] = std::string(p, rest);
+			break;
+		}
+
+		case TraceMesh:
+		{
+			const GLuint handle(get<GLuint>(p));
+			const GLenum mode(get<GLenum>(p));
+			const GLint dim(get<GLint>(p));
+			const GLsizei vertexcount(get<GLsizei>(p)), indexcount(get<GLsizei>(p));
+			if (vertexcount < 0 || indexcount < 0
+				|| static_cast<std::size_t>(vertexcount) * sizeof(Object::Vertex)
+				+ static_cast<std::size_t>(indexcount) * sizeof(GLuint) > rest)
+			{
+				reject(op);
+				break;
+			}
+			if (meshes.count(handle) > 0) break;
+
+			// 記録の中は境界が揃っていないので写してから使う
+			std::vector<Object::Vertex> vertex(vertexcount);
+			std::vector<GLuint> index(indexcount);
+			memcpy(vertex.data(), p, vertexcount * sizeof(Object::Vertex));
+			memcpy(index.data(), p + vertexcount * sizeof(Object::Vertex), indexcount * sizeof(GLuint));
+
+			// 範囲外のインデックスは GPU が頂点バッファの外を読むので作らない
+			if (!checkMesh(mode, dim, vertexcount, indexcount, index.data()))
+			{
+				reject(op);
+				break;
+			}
+			meshes[handle].reset(new TraceShape(mode, dim, vertexcount, vertex.data(), indexcount, index.data()));
+			break;
+		}
+
+		case TraceFrame:
+			time = get<double>(p);
+			break;
+
+		case TraceInput:
+		{
+			// 記録したのはウィンドウの大きさなのでフレームバッファの大きさにする
+			const GLfloat width(get<GLfloat>(p)), height(get<GLfloat>(p));
+			glViewport(0, 0, static_cast<GLsizei>(width * framebufferScale[0] + 0.5f),
+				static_cast<GLsizei>(height * framebufferScale[1] + 0.5f));
+			break;
+		}
+
+		case TraceUseProgram:
+			current = get<GLuint>(p);
+			glUseProgram(programs[current]);
+			break;
+
+		case TraceUniform:
+		{
+			const GLint recorded(get<GLint>(p));
+			const GLenum type(get<GLenum>(p));
+			const GLsizei n(TraceRecorder::uniformSize(type));
+			if (n == 0 || n * sizeof(GLfloat) > rest)
+			{
+				reject(op);
+				break;
+			}
+
+			const GLint location(locate(recorded));
+			GLfloat value[16];
+			memcpy(value, p, n * sizeof(GLfloat));
+
+			switch (type)
+			{
+			case GL_FLOAT: glUniform1fv(location, 1, value); break;
+			case GL_FLOAT_VEC2: glUniform2fv(location, 1, value); break;
+			case GL_FLOAT_VEC3: glUniform3fv(location, 1, value); break;
+			case GL_FLOAT_VEC4: glUniform4fv(location, 1, value); break;
+			case GL_FLOAT_MAT3: glUniformMatrix3fv(location, 1, GL_FALSE, value); break;
+			case GL_FLOAT_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, value); break;
+			}
+			break;
+		}
+
+		case TraceEnable:
+		{
+			const GLenum cap(get<GLenum>(p));
+			if (get<GLuint>(p) != 0) glEnable(cap); else glDisable(cap);
+			break;
+		}
+
+		case TraceClear:
+			glClear(get<GLbitfield>(p));
+			break;
+
+		case TraceDraw:
+		{
+			const std::map<GLuint, std::unique_ptr<const TraceShape>>::const_iterator mesh(meshes.find(get<GLuint>(p)));
+			if (mesh != meshes.end()) mesh->second->draw();
+			break;
+		}
+
+		case TraceDrawRanges:
+		{
+			const std::map<GLuint, std::unique_ptr<const TraceShape>>::const_iterator mesh(meshes.find(get<GLuint>(p)));
+			const GLsizei ranges(get<GLsizei>(p));
+			if (ranges < 0 || static_cast<std::size_t>(ranges) * (sizeof(GLuint) + sizeof(GLsizei)) > rest)
+			{
+				reject(op);
+				break;
+			}
+			if (mesh == meshes.end()) break;
+
+			// 再生する形状のインデックスの型に合わせて位置をバイト単位にする
+			const GLsizei size(mesh->second->getIndexSize());
+			rangeCount.clear();
+			rangeOffset.clear();
+			for (GLsizei i = 0; i < ranges; ++i)
+			{
+				const GLuint first(get<GLuint>(p));
+				const GLsizei count(get<GLsizei>(p));
+
+				// 形状のインデックスの外を指す範囲は描かない
+				if (count <= 0 || first > static_cast<GLuint>(mesh->second->getCount())
+					|| static_cast<GLuint>(count) > mesh->second->getCount() - first) continue;
+
+				rangeCount.push_back(count);
+				rangeOffset.push_back(static_cast<const GLubyte*>(0) + static_cast<std::size_t>(first) * size);
+			}
+			mesh->second->draw(static_cast<GLsizei>(rangeCount.size()), rangeCount.data(), rangeOffset.data());
+			break;
+		}
+
+		// 知らないコマンドは飛ばす
+		}
+	}
+
+public:
+	/*
+	 * @brief トレースファイルを読み込む
+	 * @param name: ファイル名
+	 * @return      読み込みに成功すれば true
+	 */
+	bool load(const char* name)
+	{
+		if (!reader.load(name)) return false;
+
+		// 最初の入力からウィンドウの大きさを取り出しておく
+		GLuint op, length;
+		const char* p;
+		while (reader.next(op, p, length))
+		{
+			if (op == TraceInput && length >= sizeof size)
+			{
+				memcpy(size, p, sizeof size);
+				break;
+			}
+		}
+		reader.rewind();
+
+		return true;
+	}
+
+	/*
+	 * @brief 次のフレームを再生する
+	 * @return フレームの終わりまで再生できれば true、トレースの終わりなら false
+	 */
+	bool step()
+	{
+		GLuint op, length;
+		const char* p;
+		while (reader.next(op, p, length))
+		{
+			if (op == TracePresent) return true;
+			execute(op, p, length);
+		}
+
+		return false;
+	}
+
+	// 最初から再生し直す (作ったプログラムと形状は使い回す)
+	void rewind()
+	{
+		reader.rewind();
+	}
+
+	/*
+	 * @brief フレームバッファとウィンドウの大きさの比を設定する
+	 *        記録したウィンドウの大きさにこれを掛けてビューポートにする
+	 */
+	void setFramebufferScale(GLfloat x, GLfloat y)
+	{
+		framebufferScale[0] = x;
+		framebufferScale[1] = y;
+	}
+
+	const GLfloat* getSize() const { return size; }
+
+	double getTime() const { return time; }
+};
@@ -2,6 +2,9 @@
 #include <iostream>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "DamageTracker.h"
+#include "FrameArena.h"
+#include "Object.h"
 
 class Window
 {
@@ -12,12 +15,19 @@ private:
 	GLfloat location[2];
 	int keyStatus;
 
+	// 変化があったときだけ描画する
+	bool onDemand;
+	double maxWait;
+	DamageTracker damage;
+
 public:
 	Window(int width = 640, int height = 480, const char* title = "Hello.")
 	 : window(glfwCreateWindow(width, height, title, NULL, NULL)),
 	   scale(100.f),
 	   location{ 0.f, 0.f },
-	   keyStatus(GLFW_RELEASE)
+	   keyStatus(GLFW_RELEASE),
+	   onDemand(false),
+	   maxWait(0.5)
 	{
 		if (window == NULL)
 		{
@@ -44,17 +54,29 @@ public:
 
         glfwSetKeyCallback(window, keyboard);
 
+		glfwSetWindowRefreshCallback(window, refresh);
+
 		resize(window, width, height);
 	}
 	
 	virtual ~Window()
 	{
+		// 削除を待っている形状はコンテキストがあるうちに消す
+		Object::clearRetired();
+
 		glfwDestroyWindow(window);
 	}
 
 	explicit operator bool()
 	{
-		glfwPollEvents();
+		// 描画の必要がなければイベントが来るまで待つ
+		const double timeout(onDemand ? damage.timeout(glfwGetTime(), maxWait) : 0.0);
+		if (timeout > 0.0)
+			glfwWaitEventsTimeout(timeout);
+		else
+			glfwPollEvents();
+
+		const GLfloat last[] = { location[0], location[1] };
 
         if (glfwGetKey(window, GLFW_KEY_LEFT) != GLFW_RELEASE)
             location[0] -= 2.f / size[0];
@@ -75,15 +97,93 @@ public:
 			location[1] = 1.f - static_cast<GLfloat>(y) * 2.f / size[1];
 		}
 
+		if (location[0] != last[0] || location[1] != last[1])
+			damage.input(glfwGetTime());
+
 		return !glfwWindowShouldClose(window) && !glfwGetKey(window, GLFW_KEY_ESCAPE);
 		
 	}
 
-	void swapBuffers() const
+	void swapBuffers()
 	{
 		glfwSwapBuffers(window);
+		damage.presented(glfwGetTime());
+
+		// 一時データの領域を次のフレームに切り替える
+		FrameArena::advance();
+
+		// 描画の終わったフレームで捨てた形状を削除する
+		Object::advance();
+	}
+
+	/*
+	 * @brief このフレームを描画するかどうか
+	 *        描画しないときは swapBuffers() を呼ばずに次のフレームに進む
+	 * @return 常時描画のとき、または変化があったとき true
+	 */
+	bool redraw()
+	{
+		if (!onDemand || damage.needsRedraw(glfwGetTime())) return true;
+
+		damage.skip();
+		return false;
 	}
 
+	/*
+	 * @brief 変化があったときだけ描画するようにする
+	 * @param enable:  true なら変化があるまでイベントを待つ
+	 * @param maxWait: イベントを待つ時間の上限 (秒)
+	 */
+	void setOnDemand(bool enable, double maxWait = 0.5)
+	{
+		onDemand = enable;
+		this->maxWait = maxWait;
+		damage.invalidate();
+	}
+
+	// 画面全体を描き直す
+	void invalidate()
+	{
+		damage.invalidate();
+	}
+
+	// 一部分を描き直す (フレームバッファの画素単位、左下が原点)
+	void invalidate(int x, int y, int width, int height)
+	{
+		damage.invalidate(x, y, width, height);
+	}
+
+	// seconds 秒の間は描画し続ける (無限大ならアニメーションを止めるまで)
+	void animate(double seconds)
+	{
+		damage.animate(glfwGetTime() + seconds);
+	}
+
+	void stopAnimation()
+	{
+		damage.stop();
+	}
+
+	/*
+	 * @brief このフレームで書き換える範囲をシザーテストに設定する
+	 * @return 一部分だけ書き換えるなら true、画面全体なら false (シザーテストは無効)
+	 */
+	bool scissorDamage() const
+	{
+		DamageTracker::Rect rect;
+		if (!damage.getDamage(rect, glfwGetTime()))
+		{
+			glDisable(GL_SCISSOR_TEST);
+			return false;
+		}
+
+		glScissor(rect.x, rect.y, rect.width, rect.height);
+		glEnable(GL_SCISSOR_TEST);
+		return true;
+	}
+
+	const DamageTracker::Stats& getFrameStats() const { return damage.getStats(); }
+
 	static void resize(GLFWwindow* const window, int width, int height)
 	{
 		int fbWidth, fbHeight;
@@ -97,6 +197,7 @@ public:
 		{
 			instance->size[0] = static_cast<GLfloat>(width);
 			instance->size[1] = static_cast<GLfloat>(height);
+			instance->damage.input(glfwGetTime());
 		}
 	}
 
@@ -107,6 +208,7 @@ public:
 		if (instance != NULL)
 		{
 			instance->scale +=static_cast<GLfloat>(y);
+			instance->damage.input(glfwGetTime());
 		}
 	}
 
@@ -117,9 +219,20 @@ public:
         if (instance != NULL)
         {
             instance->keyStatus = action;
+            instance->damage.input(glfwGetTime());
         }
     }
 
+	static void refresh(GLFWwindow* window)
+	{
+		Window* const instance(static_cast<Window*>(glfwGetWindowUserPointer(window)));
+
+		if (instance != NULL)
+		{
+			instance->damage.invalidate();
+		}
+	}
+
 	const GLfloat* getSize() const {return size; }
 
 	GLfloat getScale() const {return scale; }
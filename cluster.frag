@@ -0,0 +1,35 @@
+#version 150 core
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer lightIndex;
+uniform uvec3 clusterDim;
+uniform vec4 viewport;
+uniform vec2 depthRange;
+const vec3 Kdiff = vec3(0.6, 0.6, 0.2);
+in vec3 P;
+in vec3 N;
+out vec4 fragment;
+void main()
+{
+	// このフラグメントを含むクラスタ
+	uvec2 tile = uvec2(clamp((gl_FragCoord.xy - viewport.xy) / viewport.zw, 0.0, 0.999999) * vec2(clusterDim.xy));
+	float slice = log(-P.z / depthRange.x) / log(depthRange.y / depthRange.x);
+	uint k = uint(clamp(slice, 0.0, 0.999999) * float(clusterDim.z));
+	uvec2 range = texelFetch(clusterGrid, int((k * clusterDim.y + tile.y) * clusterDim.x + tile.x)).xy;
+
+	vec3 n = normalize(N);
+	vec3 Idiff = vec3(0.0);
+	for (uint i = 0u; i < range.y; ++i)
+	{
+		int l = int(texelFetch(lightIndex, int(range.x + i)).x);
+		vec4 Lpos = texelFetch(lightData, l * 2);
+		vec3 Ldiff = texelFetch(lightData, l * 2 + 1).rgb;
+
+		vec3 L = Lpos.xyz - P;
+		float d = max(length(L), 1.0e-4);
+		float a = clamp(1.0 - d / Lpos.w, 0.0, 1.0);
+		Idiff += max(dot(n, L / d), 0.0) * a * a * Kdiff * Ldiff;
+	}
+
+	fragment = vec4(Idiff, 1.0);
+}
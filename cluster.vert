@@ -0,0 +1,15 @@
+#version 150 core
+uniform mat4 modelview;
+uniform mat4 projection;
+uniform mat3 normalMatrix;
+in vec4 position;
+in vec3 normal;
+out vec3 P;
+out vec3 N;
+void main()
+{
+	vec4 Q = modelview * position;
+	P = Q.xyz / Q.w;
+	N = normalize(normalMatrix * normal);
+	gl_Position = projection * Q;
+}
@@ -11,158 +11,9 @@
 #include "ShapeIndex.h"
 #include "SolidShapeIndex.h"
 #include "SolidShape.h"
-
-
-/**
- * @brief シェーダオブジェクトのコンパイル結果を表示する
- * @param shader: Shaderオブジェクト名
- * @param str:    エラー発生箇所を示す文字列
- * @return        GL_TRUE or GL_FALSE
- */
-GLboolean printShaderInfoLog(GLuint shader, const char* str)
-{
-	GLint status;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-	if (status == GL_FALSE) 
-		std::cerr << "Compile Error in " << str << std::endl;
-
-	GLsizei bufSize;
-	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &bufSize);
-
-	if (bufSize > 1)
-	{
-		std::vector<GLchar> infoLog(bufSize);
-		GLsizei length;
-		glGetShaderInfoLog(shader, bufSize, &length, &infoLog[0]);
-		std::cerr << &infoLog[0] << std::endl;
-	}
-
-	return static_cast<GLboolean>(status);
-}
-
-/**
- * @brief プログラムオブジェクトのリンク結果を表示する
- * @param program: プログラムオブジェクト
- * @return        GL_TRUE or GL_FALSE
- */
-GLboolean printProgramInfoLog(GLuint program)
-{
-	GLint status;
-	glGetProgramiv(program, GL_LINK_STATUS, &status);
-	if (status == GL_FALSE)
-		std::cerr << "Link Error." << std::endl;
-	
-	GLsizei bufSize;
-	glGetProgramiv(program, GL_INFO_LOG_LENGTH, &bufSize);
-
-	if (bufSize > 1)
-	{
-		std::vector<GLchar> infoLog(bufSize);
-		GLsizei length;
-		glGetProgramInfoLog(program, bufSize, &length, &infoLog[0]);
-	}
-
-	return static_cast<GLboolean>(status);
-}
-
-/**
- * @brief プログラムオブジェクトを作成する 
- * @param vsrc: VertexShaderのソースプログラムの文字列
- * @param fsrc: FragmentShaderのソースプログラムの文字列
- * @return      プログラムオブジェクト
- */
-GLuint createProgram(const char* vsrc, const char* fsrc)
-{
-	// 空のプログラムオブジェクトの作成
-	const GLuint program(glCreateProgram());
-
-	if (vsrc != NULL)
-	{
-		// VertexShaderオブジェクトの作成
-		const GLuint vobj(glCreateShader(GL_VERTEX_SHADER));
-		glShaderSource(vobj, 1, &vsrc, NULL);
-		glCompileShader(vobj);
-
-		if (printShaderInfoLog(vobj, "vertex shader"))
-			glAttachShader(program, vobj);
-		glDeleteShader(vobj);
-	}
-
-	if (fsrc != NULL)
-	{
-		// FragmentShaderオブジェクトの作成
-		const GLuint fobj(glCreateShader(GL_FRAGMENT_SHADER));
-		glShaderSource(fobj, 1, &fsrc, NULL);
-		glCompileShader(fobj);
-
-		if (printShaderInfoLog(fobj, "fragment shader"))
-			glAttachShader(program, fobj);
-		glDeleteShader(fobj);
-	}
-
-	// プログラムオブジェクトをリンクする
-	glBindAttribLocation(program, 0, "position");
-	glBindAttribLocation(program, 1, "normal");
-	glBindFragDataLocation(program, 0, "fragment");
-	glLinkProgram(program);
-
-	if (printProgramInfoLog(program))
-		return program;
-
-	glDeleteProgram(program);
-	return 0;
-}
-
-/*
- * @brief シェーダのソースファイルを読み込む
- * @param name:   ファイル名
- * @param buffer: 読み込んだソースファイルのテキスト
- */
-bool readShaderSource(const char* name, std::vector<GLchar> &buffer)
-{
-	if (name == NULL) return false;
-
-	std::ifstream file(name, std::ios::binary);
-	if (file.fail())
-	{
-		std::cerr << "Error: Can't open source file: " << name << std::endl;
-		return false;
-	}
-
-	file.seekg(0L, std::ios::end);
-	GLsizei length = static_cast<GLsizei>(file.tellg());
-	buffer.resize(length + 1);
-
-	file.seekg(0L, std::ios::beg);
-	file.read(buffer.data(), length);
-	buffer[length] = '\0';
-
-	if (file.fail())
-	{
-		std::cerr << "Error: Could not read source file: " << name << std::endl;
-		file.close();
-		return false;
-	}
-
-	file.close();
-	return true;
-}
-
-/*
- * @brief シェーダのソースファイルを読み込んでプログラムオブジェクトを作成する
- * @param vert: VertexShaderのソースファイル名
- * @param frah: FragmentShaderのソースファイル名
- * @return      どちらも読み込み成功すればプログラムオブジェクトを返す
- */
-GLuint loadProgram(const char* vert, const char* frag)
-{
-	std::vector<GLchar> vsrc;
-	const bool vstat(readShaderSource(vert, vsrc));
-	std::vector<GLchar> fsrc;
-	const bool fstat(readShaderSource(frag, fsrc));
-
-	return vstat && fstat ? createProgram(vsrc.data(), fsrc.data()) : 0;
-}
+#include "SolidShapeMeshlet.h"
+#include "Program.h"
+#include "Trace.h"
 
 
 constexpr Object::Vertex rectangleVertex[] =
@@ -328,7 +179,7 @@ constexpr GLuint solidCubeFaceColorIndex36[] =
 };
 
 
-int main()
+int main(int argc, char* argv[])
 {
 	// GLFWの初期化
 	if (glfwInit() == GL_FALSE)
@@ -376,24 +227,60 @@ int main()
 	std::unique_ptr<const Shape> shape(new Shape(3, 12, octahedronVertex));
 	std::unique_ptr<const Shape> shapeCube(new ShapeIndex(3, 8, cubeVertex, 24, wireCubeIndex));
 	std::unique_ptr<const Shape> shapeCubeTriangles(new SolidShapeIndex(3, 24, solidCubeVertex, 36, solidCubeFaceColorIndex));
-	std::unique_ptr<const Shape> shapeCubeTriangles36(new SolidShapeIndex(3, 36, solidCubeVertex36, 36, solidCubeFaceColorIndex36));	
+	std::unique_ptr<const SolidShapeMeshlet> shapeCubeTriangles36(new SolidShapeMeshlet(3, 36, solidCubeVertex36, 36, solidCubeFaceColorIndex36));	
+
+	// 裏を向いたメッシュレットを描かない
+	MeshletCuller culler;
+
+	// 1 秒ごとに間引いた三角形の数と間引きにかかった時間を表示する
+	double reportTime(0.0), cullMs(0.0);
+	long long culled(0), triangles(0);
+	int frames(0);
+
+	// 引数にファイル名を与えると描画コマンドを記録する (replay で再生する)
+	std::unique_ptr<TraceRecorder> trace(argc > 1 ? new TraceRecorder(argv[1]) : NULL);
+	if (trace && !trace->isOpen()) trace.reset();
+	if (trace)
+	{
+		std::vector<GLchar> vsrc, fsrc;
+		if (readShaderSource(vertFile, vsrc) && readShaderSource(fragFile, fsrc))
+			trace->program(0, vsrc.data(), fsrc.data());
+		trace->uniformName(0, modelviewLoc, "modelview");
+		trace->uniformName(0, projectionLoc, "projection");
+		trace->uniformName(0, normalMatrixLoc, "normalMatrix");
+		const std::vector<GLuint>& index(shapeCubeTriangles36->getIndex());
+		trace->mesh(0, GL_TRIANGLES, 3, 36, solidCubeVertex36, static_cast<GLsizei>(index.size()), index.data());
+		trace->enable(GL_CULL_FACE);
+		trace->enable(GL_DEPTH_TEST);
+	}
 
 	glfwSetTime(0.0);
 
 	while (window)
 	{
+		if (!window.redraw()) continue;
+
+		const double time(glfwGetTime());
+		const GLfloat* const size(window.getSize());
+		const GLfloat* const position(window.getLocation());
+
+		if (trace)
+		{
+			trace->frame(time);
+			trace->input(size, window.getScale(), position);
+			trace->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			trace->useProgram(0);
+		}
+
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		glUseProgram(program);
-		
-		const GLfloat* const size(window.getSize());
 
 		const GLfloat fovy(window.getScale() * 0.01f);
 		const GLfloat aspect(size[0] / size[1]);
 		const Matrix projection(Matrix::perspective(fovy, aspect, 1.f, 10.f));
 
-		const GLfloat* const position(window.getLocation());
-		const Matrix r(Matrix::rotate(static_cast<GLfloat>(glfwGetTime()), 0.f, 1.f, 0.f));
+		const Matrix r(Matrix::rotate(static_cast<GLfloat>(time), 0.f, 1.f, 0.f));
 		const Matrix model(Matrix::translate(position[0], position[1], 0.f) * r);
 
 		const Matrix view(Matrix::lookat(3.f, 4.f, 5.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f));
@@ -410,13 +297,45 @@ int main()
 
 //		shape->draw();
 //		shapeCube->draw();
-		shapeCubeTriangles36->draw();
+		shapeCubeTriangles36->draw(culler, modelview, projection);
+		const MeshletCuller::Stats first(culler.getStats());
+
+		if (trace)
+		{
+			trace->uniform(projectionLoc, GL_FLOAT_MAT4, projection.data());
+			trace->uniform(modelviewLoc, GL_FLOAT_MAT4, modelview.data());
+			trace->uniform(normalMatrixLoc, GL_FLOAT_MAT3, normalMatrix);
+			trace->drawRanges(0, culler.getRangeCount(), culler.getFirst(), culler.getCount());
+		}
 
 		const Matrix modelView1(modelview * Matrix::translate(0.f, 0.f, 3.f));
 		modelView1.getNormalMatrix(normalMatrix);
 		glUniformMatrix4fv(modelviewLoc, 1, GL_FALSE, modelView1.data());
 		glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, normalMatrix);
-		shapeCubeTriangles36->draw();
+		shapeCubeTriangles36->draw(culler, modelView1, projection);
+		const MeshletCuller::Stats& second(culler.getStats());
+
+		if (trace)
+		{
+			trace->uniform(modelviewLoc, GL_FLOAT_MAT4, modelView1.data());
+			trace->uniform(normalMatrixLoc, GL_FLOAT_MAT3, normalMatrix);
+			trace->drawRanges(0, culler.getRangeCount(), culler.getFirst(), culler.getCount());
+			trace->present();
+		}
+
+		culled += first.backface + first.frustum + second.backface + second.frustum;
+		triangles += first.triangles + second.triangles;
+		cullMs += first.ms + second.ms;
+		++frames;
+		if (time - reportTime >= 1.0)
+		{
+			std::cerr << "meshlet culling: " << culled / frames << "/" << triangles / frames
+				<< " triangles culled per frame, " << cullMs / frames * 1000.0 << " us per frame" << std::endl;
+			reportTime = time;
+			cullMs = 0.0;
+			culled = triangles = 0;
+			frames = 0;
+		}
 
 		window.swapBuffers();
 	}
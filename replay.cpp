@@ -0,0 +1,109 @@
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "Window.h"
+#include "Trace.h"
+
+// main の引数で記録したトレースをウィンドウを表示せずにできるだけ速く再生し、
+// フレームごとの時間を表示する
+//
+// 使い方: replay トレースファイル [繰り返し回数]
+// 最後の回のフレームごとの時間と集計を出力する (それ以前の回はウォームアップ)
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " trace [passes]" << std::endl;
+		return 1;
+	}
+
+	// GL を使う前にトレースを読み込んでおく
+	std::unique_ptr<TracePlayer> player(new TracePlayer);
+	if (!player->load(argv[1])) return 1;
+
+	const int passes(argc > 2 ? std::max(atoi(argv[2]), 1) : 2);
+
+	if (glfwInit() == GL_FALSE)
+	{
+		std::cerr << "Can't initialize GLFW" << std::endl;
+		return 1;
+	}
+
+	atexit(glfwTerminate);
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+	const GLfloat* const size(player->getSize());
+	Window window(static_cast<int>(size[0]), static_cast<int>(size[1]), "replay");
+
+	// 垂直同期を待たない
+	glfwSwapInterval(0);
+
+	// 高解像度のディスプレイではフレームバッファがウィンドウより大きい
+	int fbWidth, fbHeight, width, height;
+	glfwGetFramebufferSize(glfwGetCurrentContext(), &fbWidth, &fbHeight);
+	glfwGetWindowSize(glfwGetCurrentContext(), &width, &height);
+	if (width > 0 && height > 0)
+		player->setFramebufferScale(static_cast<GLfloat>(fbWidth) / width, static_cast<GLfloat>(fbHeight) / height);
+
+	glClearColor(1.f, 1.f, 1.f, 0.f);
+	glClearDepth(1.0);
+	glDepthFunc(GL_LESS);
+
+	typedef std::chrono::steady_clock Clock;
+	std::vector<double> replayMs, recordMs;
+
+	for (int pass = 0; pass < passes; ++pass)
+	{
+		player->rewind();
+		replayMs.clear();
+		recordMs.clear();
+
+		double last(0.0);
+		for (;;)
+		{
+			const Clock::time_point start(Clock::now());
+			if (!player->step()) break;
+
+			// GPU の処理の終わりまで含めて測る
+			glFinish();
+			replayMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			recordMs.push_back(recordMs.empty() ? 0.0 : (player->getTime() - last) * 1000.0);
+			last = player->getTime();
+		}
+	}
+
+	std::cout << "frame,record_ms,replay_ms" << std::endl;
+	for (std::size_t i = 0; i < replayMs.size(); ++i)
+		std::cout << i << ',' << recordMs[i] << ',' << replayMs[i] << std::endl;
+
+	if (!replayMs.empty())
+	{
+		std::vector<double> sorted(replayMs);
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum(0.0);
+		for (double t : sorted) sum += t;
+
+		const std::size_t n(sorted.size());
+		std::cerr << n << " frames: "
+			<< "min " << sorted.front() << " ms, "
+			<< "mean " << sum / n << " ms, "
+			<< "p50 " << sorted[n / 2] << " ms, "
+			<< "p95 " << sorted[std::min(n - 1, n * 95 / 100)] << " ms, "
+			<< "max " << sorted.back() << " ms" << std::endl;
+	}
+
+	// GL のオブジェクトはコンテキストがあるうちに消す
+	player.reset();
+}
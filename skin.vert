@@ -0,0 +1,23 @@
+#version 150 core
+uniform mat4 modelview;
+uniform mat4 projection;
+uniform mat3 normalMatrix;
+uniform mat4 joint[64]; // SkinnedObject::maxJoints と同じ数
+const vec4 Lpos = vec4(0.0, 0.0, 5.0, 1.0);
+const vec3 Ldiff = vec3(1.0);
+const vec3 Kdiff = vec3(0.6, 0.6, 0.2);
+in vec4 position;
+in vec3 normal;
+in uvec4 bone;
+in vec4 weight;
+out vec3 Idiff;
+void main()
+{
+	mat4 S = weight.x * joint[bone.x] + weight.y * joint[bone.y]
+	       + weight.z * joint[bone.z] + weight.w * joint[bone.w];
+	vec4 P = modelview * (S * position);
+	vec3 N = normalize(normalMatrix * (mat3(S) * normal));
+	vec3 L = normalize((Lpos * P.w - P * Lpos.w).xyz);
+	Idiff = max(dot(N, L), 0.0) * Kdiff * Ldiff;
+	gl_Position = projection * P;
+}
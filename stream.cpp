@@ -0,0 +1,140 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "Window.h"
+#include "Matrix.h"
+#include "Program.h"
+#include "DynamicObject.h"
+
+// DynamicObject の書き込みの方式ごとに毎フレーム頂点を書き換えて描画し、
+// ウィンドウを表示せずに 1 秒あたりに転送できたバイト数を測る
+//
+// 使い方: stream [1 フレームの頂点数] [フレーム数]
+// 方式ごとに MB/s と GPU を待った回数を出力する
+
+/*
+ * @brief 波打つ三角形の帯を書き込む
+ * @param vertex:      書き込み先
+ * @param vertexcount: 頂点の数 (3 の倍数)
+ * @param time:        時刻
+ */
+static void wave(Object::Vertex* vertex, GLsizei vertexcount, GLfloat time)
+{
+	const GLsizei triangles(vertexcount / 3);
+	for (GLsizei t = 0; t < triangles; ++t)
+	{
+		const GLfloat x(static_cast<GLfloat>(t) / triangles * 2.f - 1.f);
+		const GLfloat w(2.f / triangles);
+		const GLfloat y(0.5f * sin(x * 6.f + time));
+		const GLfloat p[3][2] = { { x, y }, { x + w, y }, { x, y + 0.1f } };
+
+		for (int k = 0; k < 3; ++k)
+		{
+			Object::Vertex& v(vertex[t * 3 + k]);
+			v.position[0] = p[k][0];
+			v.position[1] = p[k][1];
+			v.position[2] = 0.f;
+			v.normal[0] = 0.f;
+			v.normal[1] = 0.f;
+			v.normal[2] = 1.f;
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const GLsizei vertexcount(argc > 1 ? std::max(atoi(argv[1]) / 3 * 3, 3) : 300000);
+	const int frames(argc > 2 ? std::max(atoi(argv[2]), 1) : 300);
+
+	if (glfwInit() == GL_FALSE)
+	{
+		std::cerr << "Can't initialize GLFW" << std::endl;
+		return 1;
+	}
+
+	atexit(glfwTerminate);
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+	Window window(640, 480, "stream");
+
+	// 垂直同期を待たない
+	glfwSwapInterval(0);
+
+	glClearColor(1.f, 1.f, 1.f, 0.f);
+
+	const GLuint program(loadProgram("point.vert", "point.frag"));
+	if (program == 0) return 1;
+
+	glUseProgram(program);
+	const GLfloat normalMatrix[] = { 1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f };
+	glUniformMatrix4fv(glGetUniformLocation(program, "modelview"), 1, GL_FALSE, Matrix::identity().data());
+	glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, Matrix::identity().data());
+	glUniformMatrix3fv(glGetUniformLocation(program, "normalMatrix"), 1, GL_FALSE, normalMatrix);
+
+	typedef std::chrono::steady_clock Clock;
+	const struct
+	{
+		DynamicObject::Strategy strategy;
+		const char* name;
+	}
+	strategy[] =
+	{
+		{ DynamicObject::Orphan, "orphan" },
+		{ DynamicObject::Unsynchronized, "unsynchronized" },
+		{ DynamicObject::Persistent, "persistent" },
+		{ DynamicObject::SubData, "subdata" }
+	};
+
+	std::cout << "strategy,MB/s,stalls" << std::endl;
+	for (const auto& s : strategy)
+	{
+		std::unique_ptr<DynamicObject> object(new DynamicObject(3, vertexcount, 3, s.strategy));
+
+		// Persistent が使えなければ Unsynchronized になる
+		if (object->getStrategy() != s.strategy)
+		{
+			std::cerr << s.name << ": not supported" << std::endl;
+			continue;
+		}
+
+		glFinish();
+		const Clock::time_point start(Clock::now());
+
+		for (int f = 0; f < frames; ++f)
+		{
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			Object::Vertex* const vertex(object->map(vertexcount));
+			if (vertex == NULL)
+			{
+				std::cerr << "Error: " << s.name << ": Can't map the ring buffer" << std::endl;
+				break;
+			}
+			wave(vertex, vertexcount, static_cast<GLfloat>(f) * 0.1f);
+			object->unmap();
+
+			object->draw();
+			object->fence();
+			window.swapBuffers();
+		}
+
+		// GPU が読み終えるまで含めて測る
+		glFinish();
+		const double seconds(std::chrono::duration<double>(Clock::now() - start).count());
+
+		std::cout << s.name << ',' << object->getStreamedBytes() / seconds / 1e6 << ','
+			<< object->getStallCount() << std::endl;
+	}
+
+	glDeleteProgram(program);
+}
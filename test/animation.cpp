@@ -0,0 +1,361 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+#include "../Animation.h"
+#include "../SkinnedObject.h"
+
+// Slerp の近似を acos と sin による補間と比べ、補間の速度を測る
+// AnimationClip::sample() を 1 関節ずつ補間した結果と、Character::evaluate() を
+// 四元数から作った回転で関節を合成した結果と比べ、スレッドの数ごとの姿勢の計算の速さを測る
+// キーフレームのないクリップと関節の数の上限も調べる
+// GL のコンテキストは使わない
+//
+// 使い方: animation
+// 失敗があれば 1 を返す
+
+typedef std::chrono::steady_clock Clock;
+
+// 近似の誤差の許容値 (8 項の近似そのものの誤差はおよそ 2e-5)
+static const GLfloat tolerance(5e-5f);
+
+// SIMD と 1 組ずつの近似の差の許容値 (float の丸めの違い)
+static const GLfloat rounding(1e-6f);
+
+static int failed(0);
+
+static void check(bool ok, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << what << std::endl;
+	++failed;
+}
+
+// キーフレーム ([frame][joint] の順)
+struct Keys
+{
+	GLsizei joints;
+	GLsizei frames;
+	GLfloat fps;
+	std::vector<GLfloat> rotation;
+	std::vector<GLfloat> translation;
+};
+
+static Keys randomKeys(std::mt19937& rng, GLsizei joints, GLsizei frames)
+{
+	std::normal_distribution<GLfloat> normal(0.f, 1.f);
+
+	Keys keys = { joints, frames, 30.f, std::vector<GLfloat>(frames * joints * 4), std::vector<GLfloat>(frames * joints * 3) };
+	for (GLfloat& q : keys.rotation) q = normal(rng);
+	for (GLfloat& p : keys.translation) p = normal(rng);
+
+	// 動かない関節も含める (量子化の刻みが 0 になる)
+	for (GLsizei f = 0; f < frames; ++f)
+		for (int k = 0; k < 3; ++k) keys.translation[(f * joints + 1) * 3 + k] = 0.5f;
+
+	return keys;
+}
+
+/*
+ * @brief AnimationClip と同じように量子化したキーフレームを 1 関節ずつ補間する
+ * @param keys:        キーフレーム
+ * @param time:        時刻 (秒)
+ * @param rotation:    関節ごとの回転の四元数 (関節ごとに x, y, z, w)
+ * @param translation: 関節ごとの平行移動 (関節ごとに x, y, z)
+ */
+static void referenceSample(const Keys& keys, GLfloat time, GLfloat* rotation, GLfloat* translation)
+{
+	const GLfloat position(std::max(time * keys.fps, 0.f));
+	const GLsizei f0(static_cast<GLsizei>(position) % keys.frames), f1((f0 + 1) % keys.frames);
+	const GLfloat t(position - floor(position));
+
+	for (GLsizei j = 0; j < keys.joints; ++j)
+	{
+		GLfloat q[2][4];
+		for (int e = 0; e < 2; ++e)
+		{
+			const GLfloat* const r(&keys.rotation[((e ? f1 : f0) * keys.joints + j) * 4]);
+			const GLfloat l(sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]));
+			for (int k = 0; k < 4; ++k)
+				q[e][k] = static_cast<GLshort>(floor(r[k] / l * 32767.f + 0.5f)) / 32767.f;
+		}
+		Slerp::scalar(q[0], q[1], t, &rotation[j * 4]);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			GLfloat lo(HUGE_VALF), hi(-HUGE_VALF);
+			for (GLsizei f = 0; f < keys.frames; ++f)
+			{
+				lo = std::min(lo, keys.translation[(f * keys.joints + j) * 3 + k]);
+				hi = std::max(hi, keys.translation[(f * keys.joints + j) * 3 + k]);
+			}
+			const GLfloat step((hi - lo) / 65535.f);
+
+			GLfloat v[2];
+			for (int e = 0; e < 2; ++e)
+			{
+				const GLfloat x(keys.translation[((e ? f1 : f0) * keys.joints + j) * 3 + k]);
+				v[e] = static_cast<GLshort>(floor((step > 0.f ? (x - lo) / step : 0.f) + 0.5f) - 32768.f) + 32768.f;
+			}
+			translation[j * 3 + k] = lo + (v[0] + (v[1] - v[0]) * t) * step;
+		}
+	}
+}
+
+// 四元数の回転軸と角度から作った回転と平行移動
+static Matrix referenceLocal(const GLfloat* q, const GLfloat* p)
+{
+	const GLfloat s(sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]));
+	const Matrix r(s > 1e-6f ? Matrix::rotate(2.f * atan2(s, q[3]), q[0], q[1], q[2]) : Matrix::identity());
+	return Matrix::translate(p[0], p[1], p[2]) * r;
+}
+
+int main()
+{
+	std::mt19937 rng(3);
+	std::normal_distribution<GLfloat> normal(0.f, 1.f);
+	std::uniform_real_distribution<GLfloat> uniform(0.f, 1.f);
+
+	// 補間する四元数の組 (近い組、反対向きの組、同じ組を含める)
+	const int count(1 << 16);
+	std::vector<GLfloat> q0(count * 4), q1(count * 4), t(count);
+	for (int i = 0; i < count; ++i)
+	{
+		GLfloat* const a(&q0[i * 4]);
+		GLfloat* const b(&q1[i * 4]);
+		GLfloat la(0.f), lb(0.f);
+		for (int k = 0; k < 4; ++k)
+		{
+			a[k] = normal(rng);
+			b[k] = i % 8 == 1 ? a[k] + normal(rng) * 1e-3f : normal(rng);
+			la += a[k] * a[k];
+			lb += b[k] * b[k];
+		}
+		for (int k = 0; k < 4; ++k)
+		{
+			a[k] /= sqrt(la);
+			b[k] /= sqrt(lb);
+			if (i % 8 == 2) b[k] = -a[k];
+			if (i % 8 == 3) b[k] = a[k];
+		}
+		t[i] = i % 16 == 4 ? 0.f : i % 16 == 5 ? 1.f : uniform(rng);
+	}
+
+	// 1 組ずつの近似と基準の補間
+	std::vector<GLfloat> ref(count * 4), sca(count * 4), vec(count * 4);
+	for (int i = 0; i < count; ++i)
+	{
+		Slerp::reference(&q0[i * 4], &q1[i * 4], t[i], &ref[i * 4]);
+		Slerp::scalar(&q0[i * 4], &q1[i * 4], t[i], &sca[i * 4]);
+	}
+
+#if defined(__SSE2__) || defined(_M_X64)
+	// 4 組ずつ SoA に並べ替えて SIMD で補間する
+	const auto simd([&]
+	{
+		for (int i = 0; i < count; i += 4)
+		{
+			__m128 a[4], b[4], q[4];
+			for (int k = 0; k < 4; ++k)
+			{
+				a[k] = _mm_setr_ps(q0[i * 4 + k], q0[i * 4 + 4 + k], q0[i * 4 + 8 + k], q0[i * 4 + 12 + k]);
+				b[k] = _mm_setr_ps(q1[i * 4 + k], q1[i * 4 + 4 + k], q1[i * 4 + 8 + k], q1[i * 4 + 12 + k]);
+			}
+			Slerp::simd(a, b, _mm_loadu_ps(&t[i]), q);
+			_MM_TRANSPOSE4_PS(q[0], q[1], q[2], q[3]);
+			for (int j = 0; j < 4; ++j) _mm_storeu_ps(&vec[(i + j) * 4], q[j]);
+		}
+	});
+	simd();
+#else
+	vec = sca;
+#endif
+
+	GLfloat scalarError(0.f), simdError(0.f), simdScalar(0.f);
+	for (int i = 0; i < count * 4; ++i)
+	{
+		scalarError = std::max(scalarError, std::abs(sca[i] - ref[i]));
+		simdError = std::max(simdError, std::abs(vec[i] - ref[i]));
+		simdScalar = std::max(simdScalar, std::abs(vec[i] - sca[i]));
+	}
+	std::cout << "max error: scalar " << scalarError << ", simd " << simdError
+		<< ", simd - scalar " << simdScalar << std::endl;
+	check(scalarError <= tolerance, "scalar slerp matches the reference");
+	check(simdError <= tolerance, "simd slerp matches the reference");
+	check(simdScalar <= rounding, "simd slerp matches the scalar slerp");
+
+	// 補間の速度
+	{
+		const int passes(20);
+		double ms[3];
+
+		Clock::time_point start(Clock::now());
+		for (int p = 0; p < passes; ++p)
+			for (int i = 0; i < count; ++i) Slerp::reference(&q0[i * 4], &q1[i * 4], t[i], &ref[i * 4]);
+		ms[0] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for (int p = 0; p < passes; ++p)
+			for (int i = 0; i < count; ++i) Slerp::scalar(&q0[i * 4], &q1[i * 4], t[i], &sca[i * 4]);
+		ms[1] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+#if defined(__SSE2__) || defined(_M_X64)
+		for (int p = 0; p < passes; ++p) simd();
+#endif
+		ms[2] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		const char* const name[] = { "reference", "scalar", "simd" };
+		for (int k = 0; k < 3; ++k)
+			std::cout << name[k] << ": " << count * passes / ms[k] / 1e3 << " M slerp/s" << std::endl;
+	}
+
+	// 4 関節ずつまとめて SIMD で補間した結果を 1 関節ずつの補間と比べる
+	// (関節の数は 4 の倍数にしない)
+	{
+		const Keys keys(randomKeys(rng, 7, 10));
+		const AnimationClip clip(keys.joints, keys.frames, keys.fps, keys.rotation.data(), keys.translation.data());
+		std::vector<GLfloat> r(clip.getRotationSize()), p(clip.getTranslationSize());
+		std::vector<GLfloat> rr(keys.joints * 4), rp(keys.joints * 3);
+
+		// キーフレームちょうど、途中、最後から先頭への補間、繰り返し再生
+		const GLfloat duration(clip.getDuration());
+		const GLfloat times[] = { 0.f, 1.f / 30.f, 0.51f / 30.f, duration - 0.25f / 30.f, duration * 1.3f, 17.123f };
+
+		GLfloat rotationError(0.f), translationError(0.f);
+		for (const GLfloat time : times)
+		{
+			clip.sample(time, r.data(), p.data());
+			referenceSample(keys, time, rr.data(), rp.data());
+			for (GLsizei j = 0; j < keys.joints; ++j)
+			{
+				for (int k = 0; k < 4; ++k)
+					rotationError = std::max(rotationError, std::abs(r[j / 4 * 16 + k * 4 + j % 4] - rr[j * 4 + k]));
+				for (int k = 0; k < 3; ++k)
+					translationError = std::max(translationError, std::abs(p[j / 4 * 12 + k * 4 + j % 4] - rp[j * 3 + k]));
+			}
+		}
+		std::cout << "sample error: rotation " << rotationError << ", translation " << translationError << std::endl;
+		check(rotationError <= rounding, "sampled rotation matches the scalar reference");
+		check(translationError <= 1e-5f, "sampled translation matches the scalar reference");
+	}
+
+	// 関節の変換行列を四元数から作った回転で合成したものと比べる
+	{
+		const Keys keys(randomKeys(rng, 11, 8));
+		const AnimationClip clip(keys.joints, keys.frames, keys.fps, keys.rotation.data(), keys.translation.data());
+
+		Skeleton skeleton;
+		for (GLsizei j = 0; j < keys.joints; ++j)
+		{
+			skeleton.parent.push_back(j == 0 ? -1 : (j - 1) / 2);
+			skeleton.inverseBind.push_back(Matrix::translate(-0.1f * j, 0.2f, 0.05f * j));
+		}
+
+		Character character(&skeleton, &clip, 0.77f);
+		std::vector<GLfloat> r, p;
+		character.evaluate(r, p);
+
+		std::vector<GLfloat> rr(keys.joints * 4), rp(keys.joints * 3);
+		referenceSample(keys, character.time, rr.data(), rp.data());
+		std::vector<Matrix> world(keys.joints);
+		GLfloat error(0.f);
+		for (GLsizei j = 0; j < keys.joints; ++j)
+		{
+			const Matrix local(referenceLocal(&rr[j * 4], &rp[j * 3]));
+			world[j] = skeleton.parent[j] < 0 ? local : world[skeleton.parent[j]] * local;
+			const Matrix skin(world[j] * skeleton.inverseBind[j]);
+			for (int k = 0; k < 16; ++k) error = std::max(error, std::abs(skin[k] - character.skin[j][k]));
+		}
+		std::cout << "evaluate error: " << error << std::endl;
+		check(character.skin.size() == static_cast<std::size_t>(keys.joints), "one skin matrix per joint");
+		check(error <= 1e-3f, "evaluate matches the reference composition");
+
+		// 関節の数が違えば少ない方だけ求める
+		Skeleton small;
+		small.parent.assign(skeleton.parent.begin(), skeleton.parent.begin() + 3);
+		small.inverseBind.assign(skeleton.inverseBind.begin(), skeleton.inverseBind.begin() + 3);
+		Character fewer(&small, &clip, 0.77f);
+		fewer.evaluate(r, p);
+		check(fewer.skin.size() == 3, "skeleton with fewer joints than the clip");
+
+		const Keys few(randomKeys(rng, 4, 8));
+		const AnimationClip partial(few.joints, few.frames, few.fps, few.rotation.data(), few.translation.data());
+		Character more(&skeleton, &partial, 0.77f);
+		more.evaluate(r, p);
+		check(more.skin.size() == 4, "clip with fewer joints than the skeleton");
+	}
+
+	// スレッドの数ごとの 1 ミリ秒あたりのキャラクタの数
+	{
+		const Keys keys(randomKeys(rng, 64, 30));
+		const AnimationClip clip(keys.joints, keys.frames, keys.fps, keys.rotation.data(), keys.translation.data());
+		Skeleton skeleton;
+		for (GLsizei j = 0; j < keys.joints; ++j)
+		{
+			skeleton.parent.push_back(j - 1);
+			skeleton.inverseBind.push_back(Matrix::identity());
+		}
+
+		std::vector<Character> character;
+		for (int i = 0; i < 1000; ++i) character.push_back(Character(&skeleton, &clip, i * 0.01f));
+
+		// 1 スレッドの結果と同じになることも確かめる
+		PoseEvaluator evaluator;
+		evaluator.evaluate(character.data(), character.size(), 1);
+		const std::vector<Matrix> expected(character.back().skin);
+
+		const unsigned int hardware(std::max(std::thread::hardware_concurrency(), 1u));
+		for (const unsigned int threads : { 1u, 2u, 4u, hardware })
+		{
+			const int frames(20);
+			Clock::time_point start(Clock::now());
+			for (int f = 0; f < frames; ++f) evaluator.evaluate(character.data(), character.size(), threads);
+			const double ms(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			bool same(true);
+			for (std::size_t j = 0; j < expected.size(); ++j)
+				same = same && std::equal(expected[j].data(), expected[j].data() + 16, character.back().skin[j].data());
+			check(same, "threads give the same poses");
+
+			std::cout << threads << " threads: " << character.size() * frames / ms << " characters/ms ("
+				<< keys.joints << " joints)" << std::endl;
+		}
+	}
+
+	// キーフレームのないクリップは基本姿勢になる
+	{
+		AnimationClip clip(5, 0, 30.f, NULL, NULL);
+		std::vector<GLfloat> r(clip.getRotationSize()), p(clip.getTranslationSize());
+		clip.sample(1.5f, r.data(), p.data());
+
+		bool rest(true);
+		for (GLsizei j = 0; j < 5; ++j)
+		{
+			rest = rest && r[j / 4 * 16 + j % 4] == 0.f && r[j / 4 * 16 + 12 + j % 4] == 1.f;
+			for (int k = 0; k < 3; ++k) rest = rest && p[j / 4 * 12 + k * 4 + j % 4] == 0.f;
+		}
+		check(rest, "empty clip samples the rest pose");
+	}
+
+	// 関節の番号の上限
+	{
+		SkinnedObject::Vertex v[] =
+		{
+			{ { 0.f, 0.f, 0.f }, { 0.f, 0.f, 1.f }, { 0, 63, 200, 0 }, { 0.5f, 0.5f, 0.f, 0.f } },
+			{ { 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f }, { 1, 2, 3, 4 }, { 1.f, 0.f, 0.f, 0.f } }
+		};
+		check(SkinnedObject::checkJoints(2, v), "unweighted joints may exceed the limit");
+
+		v[1].joint[0] = SkinnedObject::maxJoints;
+		check(!SkinnedObject::checkJoints(2, v), "weighted joint beyond the limit is rejected");
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,331 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <GL/glew.h>
+#include "../Primitive.h"
+#include "../Bvh.h"
+#include "../SceneBvh.h"
+
+// 形状の BVH と配置した形状の BVH で求めた最も近い交点を、全ての三角形を
+// 総当たりで調べた結果と無作為な半直線で比べ、構築時間と 1 秒あたりの半直線の数を測る
+// GL のコンテキストは使わない
+//
+// 使い方: bvh
+// 失敗があれば 1 を返す
+
+typedef std::chrono::steady_clock Clock;
+
+static int failed(0);
+
+static void check(bool ok, const char* name, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << name << ": " << what << std::endl;
+	++failed;
+}
+
+/*
+ * @brief 三角形と半直線の交点を求める (MeshBvh と同じ Möller–Trumbore)
+ * @param p0, p1, p2: 三角形の頂点の位置
+ * @param origin:     半直線の始点
+ * @param direction:  半直線の方向
+ * @return            交点までの t、交わらなければ負の値
+ */
+static GLfloat intersect(const GLfloat* p0, const GLfloat* p1, const GLfloat* p2,
+	const GLfloat* origin, const GLfloat* direction)
+{
+	const GLfloat e1[] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const GLfloat e2[] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	const GLfloat p[] =
+	{
+		direction[1] * e2[2] - direction[2] * e2[1],
+		direction[2] * e2[0] - direction[0] * e2[2],
+		direction[0] * e2[1] - direction[1] * e2[0]
+	};
+	const GLfloat det(e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2]);
+	if (det == 0.f) return -1.f;
+
+	const GLfloat invdet(1.f / det);
+	const GLfloat s[] = { origin[0] - p0[0], origin[1] - p0[1], origin[2] - p0[2] };
+	const GLfloat u((s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invdet);
+	if (u < 0.f || u > 1.f) return -1.f;
+
+	const GLfloat q[] =
+	{
+		s[1] * e1[2] - s[2] * e1[1],
+		s[2] * e1[0] - s[0] * e1[2],
+		s[0] * e1[1] - s[1] * e1[0]
+	};
+	const GLfloat v((direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * invdet);
+	if (v < 0.f || u + v > 1.f) return -1.f;
+
+	const GLfloat t((e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invdet);
+	return t > 0.f ? t : -1.f;
+}
+
+// 総当たりで求めた交点
+struct Nearest
+{
+	GLint triangle;  // 三角形の番号、交わらなければ -1
+	GLint instance;  // 配置した形状の番号
+	GLfloat t;
+};
+
+// 形状の中心付近に向かう半直線 (一部は形状を外れる)
+struct RayGenerator
+{
+	std::mt19937 rng;
+	std::uniform_real_distribution<GLfloat> uniform;
+
+	RayGenerator()
+		: rng(7), uniform(-1.f, 1.f)
+	{}
+
+	void operator()(GLfloat radius, GLfloat* origin, GLfloat* direction)
+	{
+		GLfloat l(0.f);
+		do
+		{
+			for (int k = 0; k < 3; ++k) origin[k] = uniform(rng);
+			l = sqrt(origin[0] * origin[0] + origin[1] * origin[1] + origin[2] * origin[2]);
+		}
+		while (l < 0.1f || l > 1.f);
+
+		GLfloat d(0.f);
+		for (int k = 0; k < 3; ++k)
+		{
+			origin[k] *= radius / l;
+			direction[k] = uniform(rng) * 1.5f - origin[k];
+			d += direction[k] * direction[k];
+		}
+		for (int k = 0; k < 3; ++k) direction[k] /= sqrt(d);
+	}
+};
+
+/*
+ * @brief 形状の BVH を総当たりと比べる
+ * @param name:   形状の名前
+ * @param vertex: 頂点属性
+ * @param index:  三角形の頂点のインデックス (空なら頂点を順に 3 つずつ使う)
+ */
+static void testMesh(const char* name, const std::vector<Object::Vertex>& vertex, const std::vector<GLuint>& index)
+{
+	const GLsizei indexcount(static_cast<GLsizei>(index.empty() ? vertex.size() : index.size()));
+	const GLuint* const ip(index.empty() ? NULL : index.data());
+	const GLsizei triangles(indexcount / 3);
+
+	Clock::time_point start(Clock::now());
+	const MeshBvh bvh(vertex.data(), indexcount, ip);
+	const double build(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+	const int rays(2000);
+	std::vector<GLfloat> ray(rays * 6);
+	RayGenerator generate;
+	for (int r = 0; r < rays; ++r) generate(4.f, &ray[r * 6], &ray[r * 6 + 3]);
+
+	// 総当たり
+	std::vector<Nearest> expected(rays);
+	start = Clock::now();
+	for (int r = 0; r < rays; ++r)
+	{
+		Nearest& n(expected[r]);
+		n.triangle = -1;
+		n.t = 0.f;
+		for (GLsizei i = 0; i < triangles; ++i)
+		{
+			const GLfloat t(intersect(
+				vertex[ip != NULL ? ip[i * 3 + 0] : i * 3 + 0].position,
+				vertex[ip != NULL ? ip[i * 3 + 1] : i * 3 + 1].position,
+				vertex[ip != NULL ? ip[i * 3 + 2] : i * 3 + 2].position,
+				&ray[r * 6], &ray[r * 6 + 3]));
+			if (t > 0.f && (n.triangle < 0 || t < n.t))
+			{
+				n.triangle = i;
+				n.t = t;
+			}
+		}
+	}
+	const double brute(std::chrono::duration<double>(Clock::now() - start).count());
+
+	// 辺や頂点を通る半直線は隣の三角形に当たってもよいので、t が一致すればよい
+	int missed(0), wrong(0), hits(0);
+	for (int r = 0; r < rays; ++r)
+	{
+		MeshBvh::Hit hit;
+		const bool found(bvh.intersect(&ray[r * 6], &ray[r * 6 + 3], std::numeric_limits<GLfloat>::max(), hit));
+		const Nearest& n(expected[r]);
+		if (found != (n.triangle >= 0)) ++missed;
+		else if (found && hit.triangle != static_cast<GLuint>(n.triangle) && std::abs(hit.t - n.t) > 1e-5f * n.t) ++wrong;
+		else if (found && std::abs(hit.t - n.t) > 1e-6f * n.t) ++wrong;
+		if (found) ++hits;
+	}
+	check(missed == 0, name, "hit or miss agrees with brute force");
+	check(wrong == 0, name, "nearest triangle and t agree with brute force");
+	check(hits > rays / 4, name, "rays hit the mesh");
+
+	// 速さは何度も繰り返して測る
+	const int passes(200);
+	int repeated(0);
+	start = Clock::now();
+	for (int p = 0; p < passes; ++p)
+	{
+		for (int r = 0; r < rays; ++r)
+		{
+			MeshBvh::Hit hit;
+			if (bvh.intersect(&ray[r * 6], &ray[r * 6 + 3], std::numeric_limits<GLfloat>::max(), hit)) ++repeated;
+		}
+	}
+	const double seconds(std::chrono::duration<double>(Clock::now() - start).count());
+	check(repeated == hits * passes, name, "repeated rays give the same hits");
+
+	std::cout << name << ": " << triangles << " triangles, " << bvh.getNodeCount() << " nodes, build " << build
+		<< " ms, " << rays * passes / seconds * 1e-6 << " Mrays/s (brute force " << rays / brute * 1e-6
+		<< " Mrays/s), " << hits << "/" << rays << " hits" << std::endl;
+}
+
+/*
+ * @brief 拡大縮小や回転をして並べた形状の BVH を総当たりと比べる
+ *        t はワールド座標系の半直線のパラメータになることを確かめる
+ */
+static void testScene()
+{
+	const char* const name("scene");
+
+	std::vector<Object::Vertex> sphere, torus, cube;
+	std::vector<GLuint> sphereIndices, torusIndices, cubeIndices;
+	sphereVertex(sphere, 32, 16);
+	sphereIndex(sphereIndices, 32, 16);
+	torusVertex(torus, 32, 16);
+	torusIndex(torusIndices, 32, 16);
+	subdividedCubeVertex(cube, 4);
+	subdividedCubeIndex(cubeIndices, 4);
+
+	const struct
+	{
+		const std::vector<Object::Vertex>* vertex;
+		const std::vector<GLuint>* index;
+	}
+	mesh[] = { { &sphere, &sphereIndices }, { &torus, &torusIndices }, { &cube, &cubeIndices } };
+
+	std::vector<const MeshBvh*> bvh;
+	for (const auto& m : mesh)
+		bvh.push_back(new MeshBvh(m.vertex->data(), static_cast<GLsizei>(m.index->size()), m.index->data()));
+
+	// 形状は描画しないので Shape は使わない
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<GLfloat> uniform(-1.f, 1.f);
+	SceneBvh scene;
+	std::vector<Matrix> model;
+	std::vector<int> kind;
+	const int instances(200);
+	for (int i = 0; i < instances; ++i)
+	{
+		const GLfloat s(0.1f + (uniform(rng) + 1.f) * 0.2f);
+		const Matrix m(Matrix::translate(uniform(rng) * 4.f, uniform(rng) * 4.f, uniform(rng) * 4.f)
+			* Matrix::rotate(uniform(rng) * 3.f, uniform(rng), uniform(rng), 1.f)
+			* Matrix::scale(s, s * 2.f, s * 0.5f));
+		model.push_back(m);
+		kind.push_back(i % 3);
+		scene.add(NULL, bvh[i % 3], m);
+	}
+
+	Clock::time_point start(Clock::now());
+	scene.build();
+	const double build(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+	// ワールド座標系の三角形
+	std::vector<GLfloat> world;
+	std::vector<GLint> owner;
+	for (int i = 0; i < instances; ++i)
+	{
+		const auto& m(mesh[kind[i]]);
+		for (const GLuint v : *m.index)
+		{
+			const GLfloat p[] = { (*m.vertex)[v].position[0], (*m.vertex)[v].position[1], (*m.vertex)[v].position[2], 1.f };
+			GLfloat q[4];
+			model[i].transform(p, q);
+			world.insert(world.end(), q, q + 3);
+		}
+		owner.insert(owner.end(), m.index->size() / 3, i);
+	}
+	const std::size_t triangles(owner.size());
+
+	const int rays(1000);
+	RayGenerator generate;
+	int missed(0), wrong(0), hits(0);
+	double brute(0.0), traverse(0.0);
+	for (int r = 0; r < rays; ++r)
+	{
+		Ray ray;
+		generate(8.f, ray.origin, ray.direction);
+
+		start = Clock::now();
+		Nearest n = { -1, -1, 0.f };
+		for (std::size_t i = 0; i < triangles; ++i)
+		{
+			const GLfloat t(intersect(&world[i * 9], &world[i * 9 + 3], &world[i * 9 + 6], ray.origin, ray.direction));
+			if (t > 0.f && (n.triangle < 0 || t < n.t))
+			{
+				n.triangle = static_cast<GLint>(i);
+				n.instance = owner[i];
+				n.t = t;
+			}
+		}
+		brute += std::chrono::duration<double>(Clock::now() - start).count();
+
+		start = Clock::now();
+		SceneBvh::Hit hit;
+		const bool found(scene.intersect(ray, hit));
+		traverse += std::chrono::duration<double>(Clock::now() - start).count();
+
+		// 変換の丸め誤差があるので t は相対誤差で比べる
+		if (found != (n.triangle >= 0)) ++missed;
+		else if (found && (hit.instance != static_cast<GLuint>(n.instance) || std::abs(hit.t - n.t) > 1e-4f * n.t)) ++wrong;
+		if (found) ++hits;
+	}
+	check(missed == 0, name, "hit or miss agrees with brute force");
+	check(wrong == 0, name, "nearest instance and world-space t agree with brute force");
+	check(hits > rays / 10, name, "rays hit the instances");
+
+	std::cout << name << ": " << instances << " instances, " << triangles << " triangles, build " << build
+		<< " ms, " << rays / traverse * 1e-6 << " Mrays/s (brute force " << rays / brute * 1e-6
+		<< " Mrays/s), " << hits << "/" << rays << " hits" << std::endl;
+
+	for (const MeshBvh* b : bvh) delete b;
+}
+
+int main()
+{
+	std::vector<Object::Vertex> vertex;
+	std::vector<GLuint> index;
+
+	sphereVertex(vertex, 128, 64);
+	sphereIndex(index, 128, 64);
+	testMesh("sphere", vertex, index);
+
+	// インデックスを使わない三角形の並び
+	std::vector<Object::Vertex> soup;
+	for (const GLuint i : index) soup.push_back(vertex[i]);
+	testMesh("sphere (no index)", soup, std::vector<GLuint>());
+
+	torusVertex(vertex, 128, 64);
+	torusIndex(index, 128, 64);
+	testMesh("torus", vertex, index);
+
+	subdividedCubeVertex(vertex, 32);
+	subdividedCubeIndex(index, 32);
+	testMesh("cube", vertex, index);
+
+	gridVertex(vertex, 64, 64);
+	gridIndex(index, 64, 64);
+	testMesh("grid", vertex, index);
+
+	testScene();
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
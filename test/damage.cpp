@@ -0,0 +1,143 @@
+#include <cmath>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <GL/glew.h>
+#include "../DamageTracker.h"
+#include "../AssetStreamer.h"
+
+// DamageTracker の書き換えの判定と範囲、統計をウィンドウなしで調べる
+// 時刻は引数で与えるので GLFW も GL のコンテキストも使わない
+//
+// 使い方: damage
+// 失敗があれば 1 を返す
+
+static int failed(0);
+
+static void check(bool ok, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << what << std::endl;
+	++failed;
+}
+
+int main()
+{
+	typedef DamageTracker::Rect Rect;
+	Rect r{ 0, 0, 0, 0 };
+
+	// 最初のフレームは必ず描く
+	{
+		DamageTracker d;
+		check(d.needsRedraw(0.0), "first frame is dirty");
+		check(d.timeout(0.0, 0.5) == 0.0, "no wait while dirty");
+		check(!d.getDamage(r, 0.0), "first frame is drawn whole");
+
+		d.presented(0.0);
+		check(!d.needsRedraw(0.1), "clean after present");
+		check(d.timeout(0.1, 0.5) == 0.5, "wait while clean");
+
+		d.skip();
+		d.skip();
+		check(d.getStats().drawn == 1 && d.getStats().skipped == 2, "drawn and skipped counts");
+	}
+
+	// 一部分の書き換えは入れ替わるバックバッファの分も合わせる
+	{
+		DamageTracker d(2);
+		d.presented(0.0);
+
+		d.invalidate(10, 10, 5, 5);
+		check(d.needsRedraw(0.0), "damage needs redraw");
+		check(!d.getDamage(r, 0.0), "whole frame still in the other back buffer");
+		d.presented(0.0);
+
+		d.invalidate(40, 20, 10, 10);
+		check(d.getDamage(r, 0.0), "partial damage");
+		check(r.x == 10 && r.y == 10 && r.width == 40 && r.height == 20, "damage merges the previous frame");
+		d.presented(0.0);
+
+		d.invalidate(40, 20, 10, 10);
+		check(d.getDamage(r, 0.0) && r.x == 40 && r.width == 10, "older frames drop out of the history");
+		d.presented(0.0);
+
+		d.invalidate();
+		check(!d.getDamage(r, 0.0), "invalidate() redraws everything");
+	}
+
+	// 3 枚のバッファなら 2 フレーム前の範囲も合わせる
+	{
+		DamageTracker d(3);
+		d.presented(0.0);
+		d.invalidate(0, 0, 1, 1);
+		d.presented(0.0);
+		d.invalidate(5, 5, 1, 1);
+		check(!d.getDamage(r, 0.0), "triple buffering keeps the whole frame two frames back");
+		d.presented(0.0);
+		d.invalidate(9, 9, 1, 1);
+		check(d.getDamage(r, 0.0) && r.x == 0 && r.width == 10, "triple buffering merges two frames");
+	}
+
+	// アニメーションの間は描き続ける
+	{
+		DamageTracker d;
+		d.presented(0.0);
+		d.animate(2.0);
+		check(d.needsRedraw(1.0) && d.animating(1.0), "animating");
+		check(!d.getDamage(r, 1.0), "animation redraws everything");
+		d.presented(1.0);
+		check(!d.needsRedraw(2.5), "animation ends");
+
+		d.animate(HUGE_VAL);
+		check(d.needsRedraw(1e9), "endless animation");
+		d.stop();
+		check(!d.needsRedraw(1e9), "stop()");
+	}
+
+	// 入力から表示までの時間
+	{
+		DamageTracker d;
+		d.presented(0.0);
+		d.input(1.0);
+		d.input(1.1);
+		check(d.needsRedraw(1.1), "input needs redraw");
+		d.presented(1.25);
+		d.input(2.0);
+		d.presented(2.75);
+
+		const DamageTracker::Stats& s(d.getStats());
+		check(std::abs(s.latency - 0.5) < 1e-9 && std::abs(s.maxLatency - 0.75) < 1e-9, "input latency");
+	}
+
+	// ワーカースレッドの読み込みが終わったら update() の戻り値で描き直す
+	{
+		DamageTracker d;
+		d.presented(0.0);
+
+		AssetStreamer streamer(1);
+		std::atomic<bool> woken(false);
+		streamer.setNotify([&woken] { woken = true; });
+		streamer.submit([] { return true; }, [] { return std::size_t(16); });
+
+		bool uploaded(false);
+		for (int i = 0; i < 1000 && !uploaded; ++i)
+		{
+			uploaded = streamer.update();
+			if (!uploaded) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if (uploaded) d.invalidate();
+
+		// notify はキューに積んでから呼ばれるので少し遅れることがある
+		for (int i = 0; i < 1000 && !woken; ++i)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		check(uploaded && woken, "streamer uploads and notifies");
+		check(d.needsRedraw(0.0), "upload invalidates the window");
+		check(!streamer.update(), "nothing more to upload");
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,279 @@
+#include <cstdint>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+#include "../FrameArena.h"
+#include "../Matrix.h"
+
+// FrameArena の境界揃え、フレームを進めたときの再利用、スレッドごとの領域、
+// 領域の拡張を調べ、vector と new と速さを比べる
+// GL のコンテキストは使わない
+//
+// 使い方: framearena
+// 失敗があれば 1 を返す
+
+typedef std::chrono::steady_clock Clock;
+
+static std::atomic<int> failed(0);
+
+static void check(bool ok, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << what << std::endl;
+	++failed;
+}
+
+// 描画スレッドが advance() したフレームをワーカースレッドに伝える
+class FrameSignal
+{
+	std::atomic<int> requested, finished;
+
+public:
+	FrameSignal()
+	 : requested(-1), finished(-1)
+	{}
+
+	// 描画スレッド: frame を始めさせる
+	void request(int frame)
+	{
+		requested.store(frame, std::memory_order_release);
+	}
+
+	// 描画スレッド: frame が終わるのを待つ
+	void join(int frame)
+	{
+		while (finished.load(std::memory_order_acquire) != frame) std::this_thread::yield();
+	}
+
+	// ワーカースレッド: last の次のフレームを待つ
+	int wait(int last)
+	{
+		int frame;
+		while ((frame = requested.load(std::memory_order_acquire)) == last) std::this_thread::yield();
+		return frame;
+	}
+
+	// ワーカースレッド: frame を終える
+	void finish(int frame)
+	{
+		finished.store(frame, std::memory_order_release);
+	}
+};
+
+/*
+ * @brief ワーカースレッドで毎フレーム確保し、frames - 1 フレーム後まで内容が残り、
+ *        frames フレーム後に同じ場所が再利用されることを調べる
+ * @param signal: フレームの合図
+ * @param count:  まねるフレーム数
+ */
+static void worker(FrameSignal& signal, int count)
+{
+	const std::size_t size(4096);
+	std::vector<unsigned char*> block(count, NULL);
+
+	for (int last = -1; last + 1 < count;)
+	{
+		const int f(signal.wait(last));
+		last = f;
+
+		FrameArena& arena(FrameArena::local());
+		block[f] = static_cast<unsigned char*>(arena.allocate(size));
+		std::fill(block[f], block[f] + size, static_cast<unsigned char>(f + 1));
+
+		// 直前の frames - 1 フレームの領域はまだ書き換わっていない
+		for (int g = std::max(f - static_cast<int>(FrameArena::frames) + 1, 0); g < f; ++g)
+		{
+			bool intact(true);
+			for (std::size_t i = 0; i < size; ++i) intact = intact && block[g][i] == static_cast<unsigned char>(g + 1);
+			check(intact, "worker data survives frames - 1 frames");
+		}
+
+		// frames フレーム前と同じ領域を先頭から使い直す
+		if (f >= static_cast<int>(FrameArena::frames))
+			check(block[f] == block[f - FrameArena::frames], "region is reset after frames frames");
+
+		check(arena.getStats().used >= size && arena.getStats().used < 2 * size, "used is per frame");
+		signal.finish(f);
+	}
+}
+
+int main()
+{
+	// 境界揃え
+	{
+		FrameArena& arena(FrameArena::local());
+		arena.allocate(1, 1);
+		const std::uintptr_t m(reinterpret_cast<std::uintptr_t>(arena.allocateArray<Matrix>(4)));
+		arena.allocate(3, 1);
+		const std::uintptr_t d(reinterpret_cast<std::uintptr_t>(arena.allocate(64, 64)));
+		check(m % 16 == 0 && d % 64 == 0, "alignment");
+	}
+
+	// frames フレーム進むと領域を使い直す (デバッグ時は 0xdd で塗りつぶす)
+	{
+		FrameArena& arena(FrameArena::local());
+		FrameArena::advance();
+		unsigned char* const p(static_cast<unsigned char*>(arena.allocate(256)));
+		std::fill(p, p + 256, static_cast<unsigned char>(1));
+
+		for (unsigned int i = 1; i < FrameArena::frames; ++i)
+		{
+			FrameArena::advance();
+			arena.allocate(256);
+		}
+		check(p[0] == 1 && p[255] == 1, "data survives frames - 1 advances");
+
+		FrameArena::advance();
+		check(arena.getStats().used == 0, "used is reset");
+#ifndef NDEBUG
+		check(p[0] == 0xdd && p[255] == 0xdd, "recycled region is poisoned");
+#endif
+		check(arena.allocate(256) == p, "recycled region is reused from the start");
+	}
+
+	// 描画スレッドが advance() し、2 つのワーカースレッドがそれぞれの領域に確保する
+	{
+		const int count(32);
+		FrameSignal signal[2];
+		std::thread t0(worker, std::ref(signal[0]), count), t1(worker, std::ref(signal[1]), count);
+
+		for (int f = 0; f < count; ++f)
+		{
+			FrameArena::advance();
+			signal[0].request(f);
+			signal[1].request(f);
+			signal[0].join(f);
+			signal[1].join(f);
+		}
+
+		t0.join();
+		t1.join();
+	}
+
+	// 足りなければ別に確保して、次にその領域を使うときに広げる
+	{
+		std::thread t([]
+		{
+			FrameArena& arena(FrameArena::local());
+			const std::size_t before(arena.getStats().capacity);
+			check(arena.allocate(before * 2) != NULL, "overflow allocation");
+			check(arena.getStats().overflows == 1, "overflow is counted");
+
+			for (unsigned int i = 0; i < FrameArena::frames; ++i)
+			{
+				FrameArena::advance();
+				arena.allocate(1);
+			}
+			check(arena.getStats().capacity > before, "region grows after overflow");
+		});
+		t.join();
+	}
+
+	// 1 フレームに 1000 個の行列の一時配列を作る速さ
+	{
+		const int frames(2000), count(1000);
+		GLfloat sink(0.f);
+		double ms[3];
+
+		Clock::time_point start(Clock::now());
+		for (int f = 0; f < frames; ++f)
+		{
+			FrameVector<Matrix> v;
+			v.reserve(count);
+			for (int i = 0; i < count; ++i)
+			{
+				v.emplace_back();
+				v.back()[0] = static_cast<GLfloat>(i);
+			}
+			sink += v[count - 1][0];
+			FrameArena::advance();
+		}
+		ms[0] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for (int f = 0; f < frames; ++f)
+		{
+			std::vector<Matrix> v;
+			v.reserve(count);
+			for (int i = 0; i < count; ++i)
+			{
+				v.emplace_back();
+				v.back()[0] = static_cast<GLfloat>(i);
+			}
+			sink += v[count - 1][0];
+		}
+		ms[1] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		// 1 個ずつ new してフレームの終わりに delete する
+		std::vector<Matrix*> m(count);
+		start = Clock::now();
+		for (int f = 0; f < frames; ++f)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				m[i] = new Matrix;
+				(*m[i])[0] = static_cast<GLfloat>(i);
+			}
+			sink += (*m[count - 1])[0];
+			for (Matrix* p : m) delete p;
+		}
+		ms[2] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		std::cout << frames << " frames x " << count << " matrices: arena " << ms[0] << " ms, vector "
+			<< ms[1] << " ms, new " << ms[2] << " ms (" << sink << ")" << std::endl;
+	}
+
+	// 4 スレッドが毎フレーム小さな領域を確保する速さ (new/delete はフレームの終わりに解放する)
+	{
+		const int threads(4), count(256), allocations(4096);
+		double ms[2];
+
+		for (int k = 0; k < 2; ++k)
+		{
+			FrameSignal signal[threads];
+			std::vector<std::thread> worker;
+			for (int t = 0; t < threads; ++t)
+			{
+				worker.emplace_back([k, &signal, t]
+				{
+					std::vector<char*> block(allocations);
+					std::uintptr_t sink(0);
+					for (int last = -1; last + 1 < count;)
+					{
+						last = signal[t].wait(last);
+						for (int i = 0; i < allocations; ++i)
+						{
+							block[i] = k == 0 ? static_cast<char*>(FrameArena::local().allocate(48)) : new char[48];
+							block[i][0] = static_cast<char>(i);
+							sink ^= reinterpret_cast<std::uintptr_t>(block[i]);
+						}
+						if (k == 1) for (char* p : block) delete[] p;
+						signal[t].finish(last);
+					}
+					check(k == 1 || FrameArena::local().getStats().overflows == 0, "frame fits in the region");
+					check(sink != 1, "sink");
+				});
+			}
+
+			const Clock::time_point start(Clock::now());
+			for (int f = 0; f < count; ++f)
+			{
+				FrameArena::advance();
+				for (int t = 0; t < threads; ++t) signal[t].request(f);
+				for (int t = 0; t < threads; ++t) signal[t].join(f);
+			}
+			ms[k] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			for (std::thread& t : worker) t.join();
+		}
+
+		std::cout << threads << " threads x " << count << " frames x " << allocations << " allocations: arena "
+			<< ms[0] << " ms, new/delete " << ms[1] << " ms" << std::endl;
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
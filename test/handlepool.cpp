@@ -0,0 +1,157 @@
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+#include "../HandlePool.h"
+#include "../RetireQueue.h"
+
+// HandlePool の世代による古いハンドルの検出と領域の再利用、
+// RetireQueue の破棄の遅延を調べ、shared_ptr と速さを比べる
+// GL のコンテキストは使わない
+//
+// 使い方: handlepool
+// 失敗があれば 1 を返す
+
+typedef std::chrono::steady_clock Clock;
+
+struct Resource
+{
+	GLuint name;
+	GLuint size;
+};
+
+static int failed(0);
+
+static void check(bool ok, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << what << std::endl;
+	++failed;
+}
+
+int main()
+{
+	typedef HandlePool<Resource> Pool;
+
+	// 作成と参照と解放
+	{
+		Pool pool;
+		const Handle<Resource> a(pool.create(Resource{ 1, 10 }));
+		const Handle<Resource> b(pool.create(Resource{ 2, 20 }));
+		check(a && b && a != b, "handles are distinct and valid");
+		check(pool.get(a)->name == 1 && pool.get(b)->size == 20, "handles find their values");
+		check(!pool.valid(Handle<Resource>()), "null handle is invalid");
+		check(!pool.valid(Handle<Resource>(12345)), "unknown slot is invalid");
+
+		check(pool.destroy(a), "destroy");
+		check(!pool.valid(a) && pool.get(a) == NULL, "destroyed handle is stale");
+		check(!pool.destroy(a), "double destroy is rejected");
+
+		// 同じ領域を再利用しても世代が違うので古いハンドルは無効のまま
+		const Handle<Resource> c(pool.create(Resource{ 3, 30 }));
+		check((c.id & Pool::indexMask) == (a.id & Pool::indexMask), "freed slot is reused");
+		check(c != a && !pool.valid(a) && pool.get(c)->name == 3, "reused slot has a new generation");
+		check(pool.size() == 2 && pool.capacity() == 2, "size and capacity");
+
+		std::size_t visited(0);
+		pool.forEach([&visited](Resource&) { ++visited; });
+		check(visited == 2, "forEach skips freed slots");
+	}
+
+	// 世代は 0 を飛ばして一巡する
+	{
+		Pool pool;
+		const Handle<Resource> first(pool.create(Resource{ 0, 0 }));
+		pool.destroy(first);
+
+		std::size_t wrapped(0);
+		Handle<Resource> h;
+		for (GLuint i = 0; i < Pool::generationMask; ++i)
+		{
+			h = pool.create(Resource{ i, 0 });
+			if ((h.id >> Pool::indexBits) == 0) ++wrapped;
+			if (i + 1 < Pool::generationMask) pool.destroy(h);
+		}
+		check(wrapped == 0, "generation never becomes 0");
+		check(h == first, "generation wraps after generationMask reuses");
+	}
+
+	// 領域の数の上限
+	{
+		Pool pool;
+		for (GLuint i = 0; i <= Pool::indexMask; ++i) pool.create(Resource{ i, 0 });
+		check(!pool.create(Resource{ 0, 0 }), "pool refuses more than indexMask + 1 slots");
+	}
+
+	// 破棄は frames フレーム後に積んだ順で行う
+	{
+		RetireQueue<GLuint> queue(3);
+		std::vector<GLuint> removed;
+		const auto remove([&removed](GLuint name) { removed.push_back(name); });
+
+		queue.push(1);
+		queue.push(2);
+		queue.advance(remove);
+		queue.push(3);
+		queue.advance(remove);
+		check(removed.empty() && queue.size() == 3, "nothing is removed while frames are in flight");
+
+		queue.advance(remove);
+		check(removed.size() == 2 && removed[0] == 1 && removed[1] == 2, "first frame is removed after 3 frames");
+
+		queue.advance(remove);
+		check(removed.size() == 3 && removed[2] == 3 && queue.size() == 0, "second frame follows");
+
+		queue.push(4);
+		queue.clear(remove);
+		check(removed.size() == 4 && queue.size() == 0, "clear removes everything");
+	}
+
+	// shared_ptr との比較
+	{
+		const int count(1 << 20);
+		std::vector<Handle<Resource>> handles(count);
+		std::vector<std::shared_ptr<const Resource>> shared(count);
+		unsigned long sum[2] = { 0, 0 };
+		double ms[4];
+
+		Pool pool;
+		Clock::time_point start(Clock::now());
+		for (int i = 0; i < count; ++i) handles[i] = pool.create(Resource{ GLuint(i), 0 });
+		ms[0] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for (int i = 0; i < count; ++i) sum[0] += pool.get(handles[i])->name;
+		ms[1] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for (int i = 0; i < count; ++i) shared[i] = std::make_shared<const Resource>(Resource{ GLuint(i), 0 });
+		ms[2] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		// 描画リストに積むときのように参照を写して使う
+		start = Clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			const std::shared_ptr<const Resource> r(shared[i]);
+			sum[1] += r->name;
+		}
+		ms[3] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		check(sum[0] == sum[1], "benchmark sums agree");
+
+		// 解放と再利用
+		start = Clock::now();
+		for (int i = 0; i < count; i += 2) pool.destroy(handles[i]);
+		for (int i = 0; i < count; i += 2) handles[i] = pool.create(Resource{ GLuint(i), 0 });
+		const double reuse(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+		std::cout << count << " handles: create " << ms[0] << " ms, get " << ms[1] << " ms, destroy + reuse half "
+			<< reuse << " ms" << std::endl;
+		std::cout << count << " shared_ptr: make_shared " << ms[2] << " ms, copy + get " << ms[3] << " ms" << std::endl;
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
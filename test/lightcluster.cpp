@@ -0,0 +1,126 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <GL/glew.h>
+#include "../LightCluster.h"
+
+// LightCluster::assign() の結果をクラスタごとの総当たりと比べ、処理時間を測る
+// SSE2 で 4 クラスタずつ調べた結果が 1 つずつ調べた結果と同じになることを確かめる
+// GL のコンテキストは使わない
+//
+// 使い方: lightcluster
+// 失敗があれば 1 を返す
+
+typedef std::chrono::steady_clock Clock;
+
+/*
+ * @brief クラスタごとに全ての光源を 1 つずつ調べた結果と比べる
+ * @return 光源のリストが一致しないクラスタの数
+ */
+static int compare(const LightCluster& cluster, const std::vector<PointLight>& lights, const Matrix& view)
+{
+	const GLuint* const dim(cluster.getDimension());
+	const GLuint clusters(dim[0] * dim[1] * dim[2]);
+
+	std::vector<GLfloat> eye(lights.size() * 4);
+	for (std::size_t n = 0; n < lights.size(); ++n)
+	{
+		const GLfloat p[] = { lights[n].position[0], lights[n].position[1], lights[n].position[2], 1.f };
+		view.transform(p, &eye[n * 4]);
+	}
+
+	int mismatch(0);
+	std::vector<GLuint> expected;
+	for (GLuint c = 0; c < clusters; ++c)
+	{
+		GLfloat lo[3], hi[3];
+		cluster.getBounds(c, lo, hi);
+
+		expected.clear();
+		for (std::size_t n = 0; n < lights.size(); ++n)
+		{
+			GLfloat d2(0.f);
+			for (int e = 0; e < 3; ++e)
+			{
+				const GLfloat v(std::max(std::max(lo[e] - eye[n * 4 + e], eye[n * 4 + e] - hi[e]), 0.f));
+				d2 += v * v;
+			}
+			if (d2 <= lights[n].radius * lights[n].radius) expected.push_back(static_cast<GLuint>(n));
+		}
+
+		const LightCluster::Range& r(cluster.getGrid()[c]);
+		const std::vector<GLuint>& index(cluster.getIndex());
+		if (r.offset + r.count > index.size()
+			|| !std::equal(expected.begin(), expected.end(), index.begin() + r.offset)
+			|| expected.size() != r.count)
+			++mismatch;
+	}
+
+	return mismatch;
+}
+
+int main()
+{
+	int failed(0);
+
+	const Matrix projection(Matrix::perspective(1.f, 16.f / 9.f, 1.f, 100.f));
+	const Matrix view(Matrix::lookat(3.f, 4.f, 5.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f));
+
+	std::mt19937 rng(2);
+	std::uniform_real_distribution<GLfloat> position(-40.f, 40.f), radius(0.5f, 6.f);
+
+	LightCluster cluster;
+	cluster.setProjection(projection);
+
+	for (const GLsizei count : { 0, 1, 100, 1000, 10000 })
+	{
+		std::vector<PointLight> lights(count);
+		for (PointLight& l : lights)
+		{
+			l.position[0] = position(rng);
+			l.position[1] = position(rng) * 0.25f;
+			l.position[2] = position(rng);
+			l.radius = radius(rng);
+		}
+
+		// 1 スレッドと複数スレッド (2 回目はワーカースレッドを使い回す)
+		for (const unsigned int threads : { 1u, 4u, 4u, 3u })
+		{
+			const Clock::time_point start(Clock::now());
+			cluster.assign(lights.data(), count, view, threads);
+			const double ms(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+			const int mismatch(compare(cluster, lights, view));
+			std::cout << count << " lights, " << threads << " threads: " << ms << " ms, "
+				<< cluster.getIndex().size() << " pairs, " << mismatch << " mismatched clusters" << std::endl;
+			if (mismatch > 0) ++failed;
+		}
+	}
+
+	// 毎フレーム呼んだときの 1 回あたりの時間
+	{
+		std::vector<PointLight> lights(1000);
+		for (PointLight& l : lights)
+		{
+			l.position[0] = position(rng);
+			l.position[1] = position(rng) * 0.25f;
+			l.position[2] = position(rng);
+			l.radius = radius(rng);
+		}
+
+		for (const unsigned int threads : { 1u, 2u, 4u })
+		{
+			const int frames(200);
+			const Clock::time_point start(Clock::now());
+			for (int i = 0; i < frames; ++i) cluster.assign(lights.data(), 1000, view, threads);
+			const double ms(std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames);
+
+			std::cout << "1000 lights, " << threads << " threads: " << ms << " ms/frame" << std::endl;
+		}
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <GL/glew.h>
+#include "../Mesh.h"
+
+// readMesh() が正しい形状ファイルを読み込み、壊れたファイルを受け付けないことを調べる
+// GL のコンテキストは使わない (作業用のファイルをカレントディレクトリに作って消す)
+//
+// 使い方: mesh
+// 失敗があれば 1 を返す
+
+static int failed(0);
+
+static void check(bool ok, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << what << std::endl;
+	++failed;
+}
+
+// ファイルの中身
+static std::vector<char> load(const char* name)
+{
+	std::ifstream file(name, std::ios::binary);
+	return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void save(const char* name, const std::vector<char>& data)
+{
+	std::ofstream file(name, std::ios::binary);
+	file.write(data.data(), data.size());
+}
+
+/*
+ * @brief ファイルの一部を書き換えて読み込めないことを調べる
+ * @param data:   元のファイルの中身
+ * @param offset: 書き換える位置
+ * @param value:  書き込む値
+ * @param what:   調べる内容
+ */
+template <typename T>
+static void reject(const std::vector<char>& data, std::size_t offset, T value, const char* what)
+{
+	const char* const bad("mesh_bad.mesh");
+	std::vector<char> patched(data);
+	std::memcpy(&patched[offset], &value, sizeof value);
+	save(bad, patched);
+
+	Mesh m;
+	check(!readMesh(bad, m), what);
+}
+
+int main()
+{
+	const char* const name("mesh_test.mesh");
+	const char* const bad("mesh_bad.mesh");
+
+	// 頂点を共有する立方体
+	Mesh mesh;
+	mesh.size = 3;
+	for (int i = 0; i < 8; ++i)
+	{
+		const GLfloat x(i & 1 ? 1.f : -1.f), y(i & 2 ? 1.f : -1.f), z(i & 4 ? 1.f : -1.f);
+		mesh.vertex.push_back(Object::Vertex{ { x, y, z }, { x * 0.57735f, y * 0.57735f, z * 0.57735f } });
+	}
+	mesh.index =
+	{
+		0, 4, 6, 0, 6, 2, // 左
+		1, 3, 7, 1, 7, 5, // 右
+		0, 1, 5, 0, 5, 4, // 下
+		2, 6, 7, 2, 7, 3, // 上
+		0, 2, 3, 0, 3, 1, // 裏
+		4, 5, 7, 4, 7, 6  // 前
+	};
+	check(writeMesh(name, mesh), "write");
+
+	// 書き出したものをそのまま読み込める
+	{
+		Mesh m;
+		check(readMesh(name, m), "read");
+		check(m.size == 3 && m.index == mesh.index && m.vertex.size() == mesh.vertex.size()
+			&& std::memcmp(m.vertex.data(), mesh.vertex.data(), mesh.vertex.size() * sizeof(Object::Vertex)) == 0,
+			"round trip");
+	}
+
+	const std::vector<char> data(load(name));
+	const std::size_t indexOffset(sizeof(MeshHeader) + mesh.vertex.size() * sizeof(Object::Vertex));
+
+	// 頂点の位置の次元は 1 から 4
+	reject(data, offsetof(MeshHeader, size), GLint(0), "size 0 is rejected");
+	reject(data, offsetof(MeshHeader, size), GLint(5), "size 5 is rejected");
+
+	// 頂点の範囲外を指すインデックス
+	reject(data, indexOffset, static_cast<GLuint>(mesh.vertex.size()), "index equal to vertexcount is rejected");
+	reject(data, data.size() - sizeof(GLuint), GLuint(0xffffffff), "huge index is rejected");
+
+	// 壊れた要素数
+	reject(data, offsetof(MeshHeader, vertexcount), GLsizei(-1), "negative vertex count is rejected");
+	reject(data, offsetof(MeshHeader, vertexcount), GLsizei(0x7fffffff), "huge vertex count is rejected");
+	reject(data, offsetof(MeshHeader, indexcount), GLsizei(0x7fffffff), "huge index count is rejected");
+
+	// 頂点を減らすと最後の頂点を指すインデックスが範囲外になる
+	reject(data, offsetof(MeshHeader, vertexcount), static_cast<GLsizei>(mesh.vertex.size() - 1), "fewer vertices than indexed are rejected");
+
+	// 途中で切れたファイル
+	for (const std::size_t size : { std::size_t(3), sizeof(MeshHeader), indexOffset, data.size() - 1 })
+	{
+		save(bad, std::vector<char>(data.begin(), data.begin() + size));
+		Mesh m;
+		check(!readMesh(bad, m), "truncated file is rejected");
+	}
+
+	std::remove(name);
+	std::remove(bad);
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,290 @@
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <GL/glew.h>
+#include "../Primitive.h"
+#include "../Mesh.h"
+
+// 差分の可変長符号の往復と壊れた符号の検出、圧縮した形状ファイルの読み込みを調べ、
+// 符号を戻す速さと圧縮率を測る
+// GL のコンテキストは使わない (作業用のファイルをカレントディレクトリに作って消す)
+//
+// 使い方: meshcodec
+// 失敗があれば 1 を返す
+
+typedef std::chrono::steady_clock Clock;
+
+static int failed(0);
+
+static void check(bool ok, const char* name, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << name << ": " << what << std::endl;
+	++failed;
+}
+
+// SIMD を使わずに 1 値ずつ戻す (decodeDelta() と比べる)
+static std::size_t referenceDecode(const GLubyte* in, std::size_t size, GLuint* value, std::size_t count)
+{
+	std::size_t p(0);
+	GLuint prev(0);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		GLuint u(0);
+		for (int shift = 0;; shift += 7)
+		{
+			if (p == size || shift > 28) return 0;
+
+			const GLubyte c(in[p++]);
+			u |= static_cast<GLuint>(c & 0x7f) << shift;
+			if (c < 0x80) break;
+		}
+		prev += static_cast<GLuint>(zigzagDecode(u));
+		value[i] = prev;
+	}
+	return p;
+}
+
+/*
+ * @brief 符号にして戻した値が元と一致し、途中で切れた符号を検出するか調べる
+ * @param name:  値の並びの名前
+ * @param value: 値の並び
+ * @return       符号のバイト数
+ */
+static std::size_t roundTrip(const char* name, const std::vector<GLuint>& value)
+{
+	std::vector<GLubyte> code;
+	encodeDelta(value.data(), value.size(), code);
+
+	std::vector<GLuint> decoded(value.size()), reference(value.size());
+	check(decodeDelta(code.data(), code.size(), decoded.data(), decoded.size()) == code.size(), name, "decode reads every byte");
+	check(decoded == value, name, "round trip");
+	check(referenceDecode(code.data(), code.size(), reference.data(), reference.size()) == code.size()
+		&& reference == value, name, "reference decode");
+
+	// 符号が足りなければ 0 を返す
+	if (!code.empty())
+		check(decodeDelta(code.data(), code.size() - 1, decoded.data(), decoded.size()) == 0, name, "truncated code");
+
+	return code.size();
+}
+
+/*
+ * @brief 符号を戻す速さを測る
+ * @param name:  値の並びの名前
+ * @param value: 値の並び
+ */
+static void bench(const char* name, const std::vector<GLuint>& value)
+{
+	std::vector<GLubyte> code;
+	encodeDelta(value.data(), value.size(), code);
+	std::vector<GLuint> decoded(value.size());
+
+	const std::size_t bytes(value.size() * sizeof(GLuint));
+	const int passes(static_cast<int>(std::max<std::size_t>(1, (std::size_t(1) << 28) / bytes)));
+	double seconds[2];
+
+	Clock::time_point start(Clock::now());
+	for (int p = 0; p < passes; ++p) decodeDelta(code.data(), code.size(), decoded.data(), decoded.size());
+	seconds[0] = std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (int p = 0; p < passes; ++p) referenceDecode(code.data(), code.size(), decoded.data(), decoded.size());
+	seconds[1] = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::cout << name << ": " << value.size() << " values, ratio " << static_cast<double>(bytes) / code.size()
+		<< ", decode " << bytes * passes / seconds[0] * 1e-9 << " GB/s (1 value at a time "
+		<< bytes * passes / seconds[1] * 1e-9 << " GB/s)" << std::endl;
+}
+
+// ファイルの先頭から size バイトを別のファイルに写す
+static void truncate(const char* from, const char* to, std::size_t size)
+{
+	std::ifstream in(from, std::ios::binary);
+	std::vector<char> data(size);
+	in.read(data.data(), size);
+	std::ofstream out(to, std::ios::binary);
+	out.write(data.data(), in.gcount());
+}
+
+// 要素数を書き換える
+static void patchCount(const char* name, GLsizei vertexcount, GLsizei indexcount)
+{
+	std::fstream file(name, std::ios::binary | std::ios::in | std::ios::out);
+	MeshHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof header);
+	header.vertexcount = vertexcount;
+	header.indexcount = indexcount;
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof header);
+}
+
+// 頂点の位置の次元を書き換える
+static void patchSize(const char* name, GLint size)
+{
+	std::fstream file(name, std::ios::binary | std::ios::in | std::ios::out);
+	MeshHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof header);
+	header.size = size;
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof header);
+}
+
+int main()
+{
+	std::mt19937 rng(3);
+
+	// 差分の符号の往復
+	{
+		// 符号なしの桁あふれで戻る差
+		roundTrip("wrap", { 0u, 0xffffffffu, 0u, 0x80000000u, 0x7fffffffu, 0x80000000u, 1u, 0xffffffffu });
+		roundTrip("empty", {});
+
+		std::vector<GLuint> random(100000);
+		for (GLuint& v : random) v = rng();
+		roundTrip("random", random);
+
+		// 1 バイトの符号が長く続くと 16 個ずつまとめて戻す
+		std::vector<GLuint> step(100000);
+		for (std::size_t i = 0; i < step.size(); ++i) step[i] = static_cast<GLuint>(i / 3 + rng() % 5);
+		roundTrip("small steps", step);
+
+		// 1 バイトの符号の間に長い符号や桁あふれする差を挟む
+		std::vector<GLuint> mixed(step);
+		for (std::size_t i = 7; i < mixed.size(); i += 37) mixed[i] = i % 2 ? 0xfffffff0u : 0x12345678u;
+		roundTrip("mixed", mixed);
+
+		// 16 個の境界に掛かる長さ
+		for (const std::size_t count : { 15, 16, 17, 31, 33 })
+		{
+			std::vector<GLuint> v(step.begin(), step.begin() + count);
+			roundTrip("short", v);
+		}
+	}
+
+	// 壊れた符号
+	{
+		std::vector<GLuint> value(64);
+
+		// 続きを示すビットが切れずに 5 バイトを超える
+		const std::vector<GLubyte> endless(32, 0xff);
+		check(decodeDelta(endless.data(), endless.size(), value.data(), 1) == 0, "corrupt", "overlong code");
+
+		// 値の数に対して符号が足りない (SIMD でまとめて戻せる長さ)
+		const std::vector<GLubyte> shortcode(20, 0x02);
+		check(decodeDelta(shortcode.data(), shortcode.size(), value.data(), 32) == 0, "corrupt", "too few codes");
+		check(decodeDelta(shortcode.data(), shortcode.size(), value.data(), 20) == 20 && value[19] == 20,
+			"corrupt", "exact codes decode");
+	}
+
+	// 圧縮した形状ファイル
+	{
+		const char* const mshz("meshcodec_test.mshz");
+		const char* const mesh("meshcodec_test.mesh");
+		const char* const bad("meshcodec_bad.mshz");
+
+		Mesh m;
+		m.size = 3;
+		sphereVertex(m.vertex, 64, 32);
+		sphereIndex(m.index, 64, 32);
+		check(writeCompressedMesh(mshz, m) && writeMesh(mesh, m), "file", "write");
+
+		Mesh z, r;
+		check(readMesh(mshz, z) && readMesh(mesh, r), "file", "read");
+		check(z.index == m.index && r.index == m.index && z.vertex.size() == m.vertex.size(), "file", "index round trip");
+
+		// 位置の誤差は量子化の刻み (半径 1 の球なら 2 / 65535) まで、法線の誤差は 1 / 65535 まで
+		GLfloat position(0.f), normal(0.f);
+		for (std::size_t i = 0; i < std::min(z.vertex.size(), m.vertex.size()); ++i)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				position = std::max(position, std::abs(z.vertex[i].position[k] - m.vertex[i].position[k]));
+				normal = std::max(normal, std::abs(z.vertex[i].normal[k] - m.vertex[i].normal[k]));
+			}
+		}
+		check(position <= 2.f / 65535.f && normal <= 1.f / 65535.f + 1e-6f, "file", "quantization error");
+
+		std::ifstream in(mshz, std::ios::binary | std::ios::ate);
+		const std::size_t size(static_cast<std::size_t>(in.tellg()));
+		in.close();
+		std::cout << "sphere file: " << m.vertex.size() * sizeof(Object::Vertex) + m.index.size() * sizeof(GLuint)
+			<< " bytes raw, " << size << " bytes compressed, position error " << position << std::endl;
+
+		// 途中で切れたファイル
+		Mesh t;
+		for (const std::size_t cut : { std::size_t(8), sizeof(MeshHeader) + 8, size / 2, size - 1 })
+		{
+			truncate(mshz, bad, cut);
+			check(!readMesh(bad, t), "file", "truncated file is rejected");
+		}
+
+		// 壊れた要素数で巨大な領域を確保しない
+		truncate(mshz, bad, size);
+		patchCount(bad, 0x7fffffff, 0x7fffffff);
+		check(!readMesh(bad, t), "file", "huge counts are rejected");
+		patchCount(bad, static_cast<GLsizei>(m.vertex.size()), 0x7fffffff);
+		check(!readMesh(bad, t), "file", "huge index count is rejected");
+
+		truncate(mesh, bad, size);
+		patchCount(bad, 0x7fffffff, 0);
+		check(!readMesh(bad, t), "file", "huge counts in an uncompressed file are rejected");
+
+		// 頂点の位置の次元は 1 から 4
+		for (const GLint s : { 0, 5 })
+		{
+			truncate(mshz, bad, size);
+			patchSize(bad, s);
+			check(!readMesh(bad, t), "file", "bad position size is rejected");
+		}
+
+		// 符号は正しくても頂点の範囲外を指すインデックス (16 bit に切り詰めると別の頂点になる値を含む)
+		for (const GLuint outside : { static_cast<GLuint>(m.vertex.size()), 65536u + 5u })
+		{
+			Mesh o(m);
+			o.index[10] = outside;
+			check(writeCompressedMesh(bad, o), "file", "write");
+			check(!readMesh(bad, t), "file", "compressed index out of range is rejected");
+		}
+
+		std::remove(mshz);
+		std::remove(mesh);
+		std::remove(bad);
+	}
+
+	// 圧縮率と符号を戻す速さ
+	{
+		std::vector<Object::Vertex> vertex;
+		std::vector<GLuint> index;
+		sphereVertex(vertex, 256, 128);
+		sphereIndex(index, 256, 128);
+		bench("sphere index", index);
+
+		GLfloat offset[3], scale[3];
+		std::vector<GLuint> stream;
+		quantizeVertex(vertex.data(), static_cast<GLsizei>(vertex.size()), offset, scale, stream);
+		bench("sphere vertex", stream);
+
+		gridVertex(vertex, 256, 256);
+		gridIndex(index, 256, 256);
+		bench("grid index", index);
+
+		// 1 バイトの符号が続く並び (SIMD でまとめて戻せる)
+		std::vector<GLuint> step(1 << 20);
+		for (std::size_t i = 0; i < step.size(); ++i) step[i] = static_cast<GLuint>(i / 3 + rng() % 5);
+		bench("small steps", step);
+
+		std::vector<GLuint> random(1 << 20);
+		for (GLuint& v : random) v = rng();
+		bench("random", random);
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include <GL/glew.h>
+#include "../Primitive.h"
+#include "../Meshlet.h"
+
+// 閉じた形状と開いた形状をメッシュレットに分け、無作為な視点で間引いた結果を
+// 三角形ごとの裏向きと視錐台の判定と比べる (見える三角形を間引いていないこと)
+// GL のコンテキストは使わない
+//
+// 使い方: meshlet
+// 失敗があれば 1 を返す
+
+typedef std::chrono::steady_clock Clock;
+
+static int failed(0);
+
+static void check(bool ok, const char* name, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << name << ": " << what << std::endl;
+	++failed;
+}
+
+/*
+ * @brief 三角形が見える可能性があるか調べる
+ * @param p:   三角形の頂点の位置
+ * @param eye: モデル座標系の視点
+ * @param mvp: モデルビュー投影変換行列
+ * @return     表を向いていて全ての頂点が同じクリップ平面の外側にあるのでなければ true
+ */
+static bool visible(const GLfloat* const p[3], const GLfloat* eye, const Matrix& mvp)
+{
+	const GLfloat e1[] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+	const GLfloat e2[] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+	const GLfloat n[] =
+	{
+		e1[1] * e2[2] - e1[2] * e2[1],
+		e1[2] * e2[0] - e1[0] * e2[2],
+		e1[0] * e2[1] - e1[1] * e2[0]
+	};
+	if ((p[0][0] - eye[0]) * n[0] + (p[0][1] - eye[1]) * n[1] + (p[0][2] - eye[2]) * n[2] >= 0.f) return false;
+
+	GLfloat clip[3][4];
+	for (int v = 0; v < 3; ++v)
+	{
+		const GLfloat q[] = { p[v][0], p[v][1], p[v][2], 1.f };
+		mvp.transform(q, clip[v]);
+	}
+	for (int k = 0; k < 3; ++k)
+	{
+		bool below(true), above(true);
+		for (int v = 0; v < 3; ++v)
+		{
+			below = below && clip[v][k] < -clip[v][3];
+			above = above && clip[v][k] > clip[v][3];
+		}
+		if (below || above) return false;
+	}
+
+	return true;
+}
+
+/*
+ * @brief メッシュレットに分けて無作為な視点で間引いた結果を調べる
+ * @param name:   形状の名前
+ * @param vertex: 頂点属性
+ * @param index:  三角形の頂点のインデックス
+ * @return        間引いた三角形の割合
+ */
+static double test(const char* name, const std::vector<Object::Vertex>& vertex, const std::vector<GLuint>& index)
+{
+	std::vector<GLuint> result;
+	std::vector<Meshlet> meshlet;
+	Clock::time_point start(Clock::now());
+	buildMeshlets(vertex.data(), static_cast<GLsizei>(vertex.size()),
+		index.data(), static_cast<GLsizei>(index.size()), result, meshlet);
+	const double build(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+	// 並べ替えただけで三角形は変わらない
+	std::multiset<std::array<GLuint, 3>> before, after;
+	for (std::size_t i = 0; i + 2 < index.size(); i += 3)
+	{
+		before.insert({ { index[i], index[i + 1], index[i + 2] } });
+		after.insert({ { result[i], result[i + 1], result[i + 2] } });
+	}
+	check(result.size() == index.size() && before == after, name, "meshlets keep every triangle");
+
+	// メッシュレットは連続して並び、頂点と三角形の数の上限を守る
+	GLuint end(0);
+	bool limits(true);
+	for (const Meshlet& m : meshlet)
+	{
+		const std::set<GLuint> used(result.begin() + m.first, result.begin() + m.first + m.count);
+		limits = limits && m.first == end && m.count % 3 == 0 && used.size() <= 64 && m.count / 3 <= 124;
+		end = m.first + m.count;
+	}
+	check(limits && end == result.size(), name, "meshlet ranges and limits");
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<GLfloat> uniform(-1.f, 1.f);
+	const Matrix projection(Matrix::perspective(1.f, 1.3f, 0.5f, 20.f));
+
+	MeshletCuller culler;
+	const int cameras(500);
+	long long culled(0), total(0), wrong(0);
+	double ms(0.0);
+	std::vector<char> drawn(result.size() / 3);
+
+	for (int c = 0; c < cameras; ++c)
+	{
+		// 形状の外から中心付近を見る
+		GLfloat eye[3];
+		do
+		{
+			for (int k = 0; k < 3; ++k) eye[k] = uniform(rng) * 5.f;
+		}
+		while (eye[0] * eye[0] + eye[1] * eye[1] + eye[2] * eye[2] < 4.f);
+		const Matrix view(Matrix::lookat(eye[0], eye[1], eye[2],
+			uniform(rng) * 0.5f, uniform(rng) * 0.5f, uniform(rng) * 0.5f, 0.f, 1.f, 0.f));
+
+		culler.cull(meshlet, view, projection);
+		const MeshletCuller::Stats& stats(culler.getStats());
+		ms += stats.ms;
+		culled += stats.backface + stats.frustum;
+		total += stats.triangles;
+
+		std::fill(drawn.begin(), drawn.end(), 0);
+		for (GLsizei r = 0; r < culler.getRangeCount(); ++r)
+		{
+			const GLuint first(culler.getFirst()[r]);
+			for (GLuint i = first; i < first + culler.getCount()[r]; i += 3) drawn[i / 3] = 1;
+		}
+
+		const Matrix mvp(projection * view);
+		for (std::size_t t = 0; t < drawn.size(); ++t)
+		{
+			if (drawn[t]) continue;
+
+			const GLfloat* const p[] =
+			{
+				vertex[result[t * 3]].position, vertex[result[t * 3 + 1]].position, vertex[result[t * 3 + 2]].position
+			};
+			if (visible(p, eye, mvp)) ++wrong;
+		}
+	}
+	check(wrong == 0, name, "no visible triangle is culled");
+
+	const double ratio(static_cast<double>(culled) / total);
+	std::cout << name << ": " << index.size() / 3 << " triangles, " << meshlet.size() << " meshlets, build "
+		<< build << " ms, culled " << ratio * 100.0 << "%, cull " << ms / cameras * 1000.0 << " us, "
+		<< wrong << " visible triangles culled" << std::endl;
+
+	return ratio;
+}
+
+int main()
+{
+	std::vector<Object::Vertex> vertex;
+	std::vector<GLuint> index;
+
+	// 閉じた形状は裏側の半分近くを間引ける
+	sphereVertex(vertex, 64, 32);
+	sphereIndex(index, 64, 32);
+	check(test("sphere", vertex, index) > 0.2, "sphere", "back faces are culled");
+
+	torusVertex(vertex, 64, 32);
+	torusIndex(index, 64, 32);
+	test("torus", vertex, index);
+
+	subdividedCubeVertex(vertex, 8);
+	subdividedCubeIndex(index, 8);
+	check(test("cube", vertex, index) > 0.2, "cube", "back faces are culled");
+
+	subdividedCubeVertex(vertex, 1);
+	subdividedCubeIndex(index, 1);
+	test("cube (1 division)", vertex, index);
+
+	// 開いた形状は下から見ると全て裏向き、上から見ると裏向きのものはない
+	gridVertex(vertex, 32, 32);
+	gridIndex(index, 32, 32);
+	test("grid", vertex, index);
+	{
+		std::vector<GLuint> result;
+		std::vector<Meshlet> meshlet;
+		buildMeshlets(vertex.data(), static_cast<GLsizei>(vertex.size()),
+			index.data(), static_cast<GLsizei>(index.size()), result, meshlet);
+
+		const Matrix projection(Matrix::perspective(1.f, 1.f, 0.5f, 20.f));
+		MeshletCuller culler;
+
+		culler.cull(meshlet, Matrix::lookat(0.f, -3.f, 0.1f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f), projection);
+		check(culler.getStats().backface == culler.getStats().triangles && culler.getRangeCount() == 0,
+			"grid", "grid seen from below is culled");
+
+		culler.cull(meshlet, Matrix::lookat(0.f, 3.f, 0.1f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f), projection);
+		check(culler.getStats().backface == 0, "grid", "grid seen from above keeps its faces");
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
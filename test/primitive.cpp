@@ -0,0 +1,146 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <GL/glew.h>
+#include "../Primitive.h"
+
+// コンパイル時に作った基本形状と実行時に作った基本形状を比べる
+// GL のコンテキストは使わない (C++17 でコンパイルすること)
+//
+// 使い方: primitive
+// 失敗があれば 1 を返す
+
+// 頂点属性の差の許容値 (float の丸めの違い)
+static const GLfloat tolerance(1e-6f);
+
+/*
+ * @brief 2 つの形状が一致し、三角形の向きが法線と合っているか調べる
+ * @param name: 形状の名前
+ * @param cv:   コンパイル時に作った頂点属性
+ * @param ci:   コンパイル時に作ったインデックス
+ * @param rv:   実行時に作った頂点属性
+ * @param ri:   実行時に作ったインデックス
+ * @return      失敗の数
+ */
+template <class V, class I>
+static int compare(const char* name, const V& cv, const I& ci,
+	const std::vector<Object::Vertex>& rv, const std::vector<GLuint>& ri)
+{
+	int failed(0);
+
+	if (cv.size() != rv.size() || ci.size() != ri.size())
+	{
+		std::cerr << name << ": size mismatch" << std::endl;
+		return 1;
+	}
+
+	GLfloat diff(0.f);
+	for (std::size_t i = 0; i < cv.size(); ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			diff = std::max(diff, std::abs(cv[i].position[k] - rv[i].position[k]));
+			diff = std::max(diff, std::abs(cv[i].normal[k] - rv[i].normal[k]));
+		}
+	}
+	if (!(diff <= tolerance))
+	{
+		std::cerr << name << ": vertex differs by " << diff << std::endl;
+		++failed;
+	}
+
+	if (!std::equal(ci.begin(), ci.end(), ri.begin()))
+	{
+		std::cerr << name << ": index differs" << std::endl;
+		++failed;
+	}
+
+	// 面の法線が頂点の法線と逆を向く三角形の数
+	int backward(0);
+	for (std::size_t t = 0; t < ri.size(); t += 3)
+	{
+		if (ri[t] >= rv.size() || ri[t + 1] >= rv.size() || ri[t + 2] >= rv.size())
+		{
+			std::cerr << name << ": index out of range" << std::endl;
+			return failed + 1;
+		}
+
+		const GLfloat* const a(rv[ri[t]].position);
+		const GLfloat* const b(rv[ri[t + 1]].position);
+		const GLfloat* const c(rv[ri[t + 2]].position);
+		const GLfloat e[] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const GLfloat f[] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		const GLfloat n[] = { e[1] * f[2] - e[2] * f[1], e[2] * f[0] - e[0] * f[2], e[0] * f[1] - e[1] * f[0] };
+
+		// 極の縮退した三角形は向きがない
+		if (n[0] * n[0] + n[1] * n[1] + n[2] * n[2] < 1e-12f) continue;
+
+		GLfloat d(0.f);
+		for (int j = 0; j < 3; ++j)
+		{
+			const GLfloat* const m(rv[ri[t + j]].normal);
+			d += n[0] * m[0] + n[1] * m[1] + n[2] * m[2];
+		}
+		if (d <= 0.f) ++backward;
+	}
+	if (backward > 0)
+	{
+		std::cerr << name << ": " << backward << " triangles face away from their normals" << std::endl;
+		++failed;
+	}
+
+	std::cout << name << ": " << rv.size() << " vertices, " << ri.size() / 3
+		<< " triangles, max difference " << diff << std::endl;
+	return failed;
+}
+
+int main()
+{
+	int failed(0);
+	std::vector<Object::Vertex> v;
+	std::vector<GLuint> i;
+
+	{
+		constexpr auto cv(sphereVertex<13, 7>(1.5f));
+		constexpr auto ci(sphereIndex<13, 7>());
+		sphereVertex(v, 13, 7, 1.5f);
+		sphereIndex(i, 13, 7);
+		failed += compare("sphere", cv, ci, v, i);
+	}
+
+	{
+		constexpr auto cv(torusVertex<9, 7>(1.f, 0.3f));
+		constexpr auto ci(torusIndex<9, 7>());
+		torusVertex(v, 9, 7, 1.f, 0.3f);
+		torusIndex(i, 9, 7);
+		failed += compare("torus", cv, ci, v, i);
+	}
+
+	{
+		constexpr auto cv(cylinderVertex<10>());
+		constexpr auto ci(cylinderIndex<10>());
+		cylinderVertex(v, 10);
+		cylinderIndex(i, 10);
+		failed += compare("cylinder", cv, ci, v, i);
+	}
+
+	{
+		constexpr auto cv(gridVertex<4, 3>());
+		constexpr auto ci(gridIndex<4, 3>());
+		gridVertex(v, 4, 3);
+		gridIndex(i, 4, 3);
+		failed += compare("grid", cv, ci, v, i);
+	}
+
+	{
+		constexpr auto cv(subdividedCubeVertex<3>());
+		constexpr auto ci(subdividedCubeIndex<3>());
+		subdividedCubeVertex(v, 3);
+		subdividedCubeIndex(i, 3);
+		failed += compare("cube", cv, ci, v, i);
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
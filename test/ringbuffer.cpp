@@ -0,0 +1,136 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <deque>
+#include <GL/glew.h>
+#include "../Object.h"
+#include "../RingBuffer.h"
+
+// RingBuffer が DynamicObject と同じ使い方で返す位置の並びを調べる
+// GL のコンテキストは使わない (フェンスはダミーの値)
+//
+// 使い方: ringbuffer
+// 失敗があれば 1 を返す
+
+// 確保した領域
+struct Range
+{
+	GLsizeiptr offset;
+	GLsizeiptr size;
+};
+
+/*
+ * @brief DynamicObject::map() と fence() の手順を frames フレーム分まねる
+ * @param vertexcount: 1 フレームに書き込む頂点の最大数
+ * @param frames:      同時に GPU が読んでいる可能性のあるフレーム数
+ * @param passes:      まねるフレーム数
+ * @param random:      書き込む頂点の数を毎フレーム変えるなら true
+ * @return             失敗の数
+ */
+static int simulate(GLsizei vertexcount, GLsizei frames, int passes, bool random)
+{
+	const GLsizeiptr stride(sizeof(Object::Vertex));
+	RingBuffer ring(static_cast<GLsizeiptr>(vertexcount) * frames * stride);
+
+	// GPU が読んでいる可能性のある領域
+	std::deque<Range> inflight;
+	int failed(0);
+
+	for (int frame = 0; frame < passes; ++frame)
+	{
+		const GLsizei n(random ? 1 + rand() % vertexcount : vertexcount);
+		const GLsizeiptr bytes(n * stride);
+
+		// 空きがなければ古いフレームから待つ
+		GLsizeiptr offset(ring.allocate(bytes, stride));
+		while (offset < 0 && ring.oldest() != NULL)
+		{
+			ring.retire();
+			inflight.pop_front();
+			offset = ring.allocate(bytes, stride);
+		}
+
+		if (offset < 0)
+		{
+			std::cerr << "n=" << vertexcount << " frame " << frame << ": allocation failed" << std::endl;
+			return failed + 1;
+		}
+
+		if (offset % stride != 0 || offset + bytes > ring.getCapacity())
+		{
+			std::cerr << "n=" << vertexcount << " frame " << frame << ": bad offset " << offset << std::endl;
+			++failed;
+		}
+
+		for (const Range& r : inflight)
+		{
+			if (offset < r.offset + r.size && r.offset < offset + bytes)
+			{
+				std::cerr << "n=" << vertexcount << " frame " << frame << ": overwrites a frame in flight" << std::endl;
+				++failed;
+			}
+		}
+
+		// DynamicObject::fence() と同じく 1 フレームを閉じる
+		ring.submit(reinterpret_cast<GLsync>(static_cast<std::intptr_t>(frame + 1)));
+		inflight.push_back(Range{ offset, bytes });
+
+		// 最大の頂点数なら frames フレームまでは待たずに確保できる
+		if (!random && frame < frames && ring.getFrameCount() != static_cast<std::size_t>(frame + 1))
+		{
+			std::cerr << "n=" << vertexcount << " frame " << frame << ": waited too early" << std::endl;
+			++failed;
+		}
+	}
+
+	return failed;
+}
+
+int main()
+{
+	int failed(0);
+
+	// 頂点の大きさは 2 のべき乗ではない
+	std::cout << "stride " << sizeof(Object::Vertex) << std::endl;
+
+	// 同じ数を書き込み続けると先頭位置は 0, n, 2n, 0, ... 頂点になる
+	for (const GLsizei n : { 1, 7, 50, 64, 1000 })
+	{
+		const GLsizeiptr stride(sizeof(Object::Vertex));
+		RingBuffer ring(n * 3 * stride);
+		for (int frame = 0; frame < 9; ++frame)
+		{
+			if (ring.getFrameCount() == 3) ring.retire();
+
+			const GLsizeiptr offset(ring.allocate(n * stride, stride));
+			if (offset != frame % 3 * n * stride)
+			{
+				std::cerr << "n=" << n << " frame " << frame << ": offset " << offset
+					<< " (expected " << frame % 3 * n * stride << ")" << std::endl;
+				++failed;
+			}
+			ring.submit(reinterpret_cast<GLsync>(static_cast<std::intptr_t>(frame + 1)));
+		}
+	}
+
+	// 固定の数と毎フレーム変わる数
+	for (const GLsizei n : { 1, 7, 50, 1000 })
+	{
+		failed += simulate(n, 3, 1000, false);
+		failed += simulate(n, 3, 1000, true);
+		failed += simulate(n, 2, 1000, true);
+	}
+
+	// 2 のべき乗の境界も従来通り
+	{
+		RingBuffer ring(256);
+		if (ring.allocate(10) != 0 || ring.allocate(16, 16) != 16 || ring.allocate(1, 64) != 64)
+		{
+			std::cerr << "power of two alignment" << std::endl;
+			++failed;
+		}
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,236 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <GL/glew.h>
+#include "../Simplify.h"
+
+// simplify() が返す誤差を総当たりで測った距離と比べ、処理速度を測る
+// GL のコンテキストは使わない
+//
+// 使い方: simplify
+// 失敗があれば 1 を返す
+
+// 点 p から三角形 abc までの距離
+static GLfloat distance(const GLfloat* p, const GLfloat* a, const GLfloat* b, const GLfloat* c)
+{
+	GLfloat ab[3], ac[3], ap[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		ab[k] = b[k] - a[k];
+		ac[k] = c[k] - a[k];
+		ap[k] = p[k] - a[k];
+	}
+	const auto dot([](const GLfloat* x, const GLfloat* y) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; });
+
+	// 三角形の面上の最近点をパラメータ (s, t) で求めて辺の上に制限する
+	const GLfloat d00(dot(ab, ab)), d01(dot(ab, ac)), d11(dot(ac, ac));
+	const GLfloat d20(dot(ap, ab)), d21(dot(ap, ac));
+	const GLfloat det(d00 * d11 - d01 * d01);
+	GLfloat s(det > 0.f ? (d11 * d20 - d01 * d21) / det : 0.f);
+	GLfloat t(det > 0.f ? (d00 * d21 - d01 * d20) / det : 0.f);
+
+	if (s < 0.f || t < 0.f || s + t > 1.f)
+	{
+		// 面の外なら 3 本の辺への最近点のうち最も近いもの
+		GLfloat best(HUGE_VALF);
+		const GLfloat* const e[][2] = { { a, b }, { b, c }, { c, a } };
+		for (const auto& edge : e)
+		{
+			GLfloat d[3], q[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				d[k] = edge[1][k] - edge[0][k];
+				q[k] = p[k] - edge[0][k];
+			}
+			const GLfloat l(dot(d, d));
+			const GLfloat u(l > 0.f ? std::min(std::max(dot(q, d) / l, 0.f), 1.f) : 0.f);
+			for (int k = 0; k < 3; ++k) q[k] -= d[k] * u;
+			best = std::min(best, dot(q, q));
+		}
+		return sqrt(best);
+	}
+
+	GLfloat q[3];
+	for (int k = 0; k < 3; ++k) q[k] = ap[k] - ab[k] * s - ac[k] * t;
+	return sqrt(dot(q, q));
+}
+
+// 頂点を設定する
+static void setVertex(Object::Vertex& v, GLfloat x, GLfloat y, GLfloat z, GLfloat nx, GLfloat ny, GLfloat nz)
+{
+	v.position[0] = x;
+	v.position[1] = y;
+	v.position[2] = z;
+	v.normal[0] = nx;
+	v.normal[1] = ny;
+	v.normal[2] = nz;
+}
+
+// 単位球 (経度方向の継ぎ目で頂点を共有するので閉じた形状になる)
+static void sphere(std::vector<Object::Vertex>& vertex, std::vector<GLuint>& index, std::size_t slices, std::size_t stacks)
+{
+	const double pi(3.14159265358979323846);
+
+	vertex.resize(slices * (stacks + 1));
+	for (std::size_t j = 0; j <= stacks; ++j)
+	{
+		const double t(pi * j / stacks);
+		for (std::size_t i = 0; i < slices; ++i)
+		{
+			const double p(2.0 * pi * i / slices);
+			const GLfloat nx(static_cast<GLfloat>(sin(t) * cos(p)));
+			const GLfloat ny(static_cast<GLfloat>(cos(t)));
+			const GLfloat nz(static_cast<GLfloat>(-sin(t) * sin(p)));
+			setVertex(vertex[j * slices + i], nx, ny, nz, nx, ny, nz);
+		}
+	}
+
+	index.clear();
+	for (std::size_t j = 0; j < stacks; ++j)
+	{
+		for (std::size_t i = 0; i < slices; ++i)
+		{
+			const GLuint a(static_cast<GLuint>(j * slices + i));
+			const GLuint b(static_cast<GLuint>(j * slices + (i + 1) % slices));
+			const GLuint c(static_cast<GLuint>(a + slices)), d(static_cast<GLuint>(b + slices));
+
+			// 極では三角形が潰れるので片方だけ作る
+			if (j > 0) index.insert(index.end(), { a, c, b });
+			if (j < stacks - 1) index.insert(index.end(), { b, c, d });
+		}
+	}
+}
+
+// xz 平面上の一辺 2 の格子
+static void grid(std::vector<Object::Vertex>& vertex, std::vector<GLuint>& index, std::size_t xdiv, std::size_t zdiv)
+{
+	vertex.resize((xdiv + 1) * (zdiv + 1));
+	for (std::size_t j = 0; j <= zdiv; ++j)
+		for (std::size_t i = 0; i <= xdiv; ++i)
+			setVertex(vertex[j * (xdiv + 1) + i], 2.f * i / xdiv - 1.f, 0.f, 2.f * j / zdiv - 1.f, 0.f, 1.f, 0.f);
+
+	index.clear();
+	for (std::size_t j = 0; j < zdiv; ++j)
+	{
+		for (std::size_t i = 0; i < xdiv; ++i)
+		{
+			const GLuint a(static_cast<GLuint>(j * (xdiv + 1) + i)), b(a + 1);
+			const GLuint c(static_cast<GLuint>(a + xdiv + 1)), d(c + 1);
+			index.insert(index.end(), { a, c, b, b, c, d });
+		}
+	}
+}
+
+// 元の頂点から間引いた面までの距離の最大値
+static GLfloat measure(const std::vector<Object::Vertex>& vertex, const std::vector<GLuint>& index, const std::vector<GLuint>& lod)
+{
+	std::vector<bool> used(vertex.size(), false);
+	for (const GLuint i : index) used[i] = true;
+
+	GLfloat worst(0.f);
+	for (std::size_t i = 0; i < vertex.size(); ++i)
+	{
+		if (!used[i]) continue;
+
+		GLfloat best(HUGE_VALF);
+		for (std::size_t t = 0; t < lod.size(); t += 3)
+			best = std::min(best, distance(vertex[i].position,
+				vertex[lod[t]].position, vertex[lod[t + 1]].position, vertex[lod[t + 2]].position));
+		worst = std::max(worst, best);
+	}
+	return worst;
+}
+
+int main()
+{
+	typedef std::chrono::steady_clock Clock;
+	int failed(0);
+
+	// 閉じた形状 (球) と平面 (格子)
+	std::vector<Object::Vertex> sphere, grid;
+	std::vector<GLuint> sphereIndex, gridIndex;
+	::sphere(sphere, sphereIndex, 32, 16);
+	::grid(grid, gridIndex, 32, 32);
+
+	// 返す誤差は元の頂点から間引いた面までの距離の最大値そのもの
+	// (LodSelector はこれを画素に換算して許容値と比べるので、実際の距離より小さくてはいけない)
+	std::vector<GLuint> lod;
+	for (const GLfloat ratio : { 0.5f, 0.25f, 0.125f, 0.0625f })
+	{
+		const GLsizei target(static_cast<GLsizei>(sphereIndex.size() / 3 * ratio) * 3);
+		const GLfloat error(simplify(sphere.data(), static_cast<GLsizei>(sphere.size()),
+			sphereIndex.data(), static_cast<GLsizei>(sphereIndex.size()), target, lod));
+		const GLfloat actual(measure(sphere, sphereIndex, lod));
+
+		std::cout << "sphere " << sphereIndex.size() / 3 << " -> " << lod.size() / 3
+			<< " triangles: error " << error << ", measured max " << actual << std::endl;
+
+		if (lod.empty() || lod.size() >= sphereIndex.size())
+		{
+			std::cerr << "sphere: triangles are not reduced" << std::endl;
+			++failed;
+		}
+		if (!(actual <= error * (1.f + 1e-5f) + 1e-7f) || !(error <= actual * (1.f + 1e-5f) + 1e-7f))
+		{
+			std::cerr << "sphere: error " << error << " differs from the measured distance " << actual << std::endl;
+			++failed;
+		}
+	}
+
+	// 平面はどれだけ間引いても誤差がない
+	{
+		const GLfloat error(simplify(grid.data(), static_cast<GLsizei>(grid.size()),
+			gridIndex.data(), static_cast<GLsizei>(gridIndex.size()), 6, lod));
+		const GLfloat actual(measure(grid, gridIndex, lod));
+
+		std::cout << "grid " << gridIndex.size() / 3 << " -> " << lod.size() / 3
+			<< " triangles: error " << error << ", measured max " << actual << std::endl;
+
+		if (lod.size() >= gridIndex.size() || error > 1e-4f || actual > 1e-4f)
+		{
+			std::cerr << "grid: error on a plane" << std::endl;
+			++failed;
+		}
+	}
+
+	// 格子で探した距離と総当たりの距離 (間引いた球の頂点を少しずらしたもの)
+	{
+		std::vector<Object::Vertex> moved(sphere);
+		for (std::size_t i = 0; i < moved.size(); ++i)
+			for (int k = 0; k < 3; ++k) moved[i].position[k] *= 1.f + 0.05f * static_cast<GLfloat>(i % 7) / 7.f;
+
+		simplify(sphere.data(), static_cast<GLsizei>(sphere.size()),
+			sphereIndex.data(), static_cast<GLsizei>(sphereIndex.size()), static_cast<GLsizei>(sphereIndex.size() / 6 * 3), lod);
+		const GLfloat grid(surfaceDistance(moved.data(), sphereIndex.data(), static_cast<GLsizei>(sphereIndex.size()), lod));
+		const GLfloat brute(measure(moved, sphereIndex, lod));
+		std::cout << "surface distance: grid " << grid << ", brute force " << brute << std::endl;
+
+		if (std::abs(grid - brute) > brute * 1e-5f + 1e-7f)
+		{
+			std::cerr << "surfaceDistance differs from brute force" << std::endl;
+			++failed;
+		}
+	}
+
+	// 処理速度 (元の三角形の数 / 秒)
+	{
+		std::vector<Object::Vertex> vertex;
+		std::vector<GLuint> index;
+		::sphere(vertex, index, 256, 128);
+
+		const int passes(5);
+		const Clock::time_point start(Clock::now());
+		for (int i = 0; i < passes; ++i)
+			simplify(vertex.data(), static_cast<GLsizei>(vertex.size()),
+				index.data(), static_cast<GLsizei>(index.size()), static_cast<GLsizei>(index.size() / 12 * 3), lod);
+		const double s(std::chrono::duration<double>(Clock::now() - start).count() / passes);
+
+		std::cout << "throughput: " << index.size() / 3 << " -> " << lod.size() / 3 << " triangles in "
+			<< s * 1000.0 << " ms (" << index.size() / 3 / s / 1e6 << " Mtri/s)" << std::endl;
+	}
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}
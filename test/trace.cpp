@@ -0,0 +1,219 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <GL/glew.h>
+#include "../Primitive.h"
+#include "../Trace.h"
+
+// TraceRecorder で記録したコマンドを TraceReader で読み戻して記録した内容と比べ、
+// 途中で切れたトレースと TracePlayer が作らない形状を調べ、記録にかかる時間を測る
+// GL のコンテキストは使わない (作業用のファイルをカレントディレクトリに作って消す)
+//
+// 使い方: trace
+// 失敗があれば 1 を返す
+
+typedef std::chrono::steady_clock Clock;
+
+static int failed(0);
+
+static void check(bool ok, const char* what)
+{
+	if (ok) return;
+
+	std::cerr << "failed: " << what << std::endl;
+	++failed;
+}
+
+// 読み戻したコマンドの引数
+struct Command
+{
+	GLuint op;
+	std::vector<char> argument;
+
+	template <typename T>
+	T get(std::size_t offset) const
+	{
+		T value;
+		memcpy(&value, &argument[offset], sizeof value);
+		return value;
+	}
+};
+
+static std::vector<Command> readAll(const char* name)
+{
+	std::vector<Command> command;
+	TraceReader reader;
+	if (!reader.load(name)) return command;
+
+	GLuint op, length;
+	const char* p;
+	while (reader.next(op, p, length)) command.push_back(Command{ op, std::vector<char>(p, p + length) });
+	return command;
+}
+
+// main.cpp と同じくらいのフレームを記録する
+static void recordFrame(TraceRecorder& trace, int f, const GLuint* first, const GLsizei* count, GLsizei ranges)
+{
+	GLfloat matrix[16];
+	for (int k = 0; k < 16; ++k) matrix[k] = static_cast<GLfloat>(f * 16 + k);
+	const GLfloat size[] = { 640.f, 480.f }, location[] = { 0.25f, -0.5f };
+
+	trace.frame(f * 0.016);
+	trace.input(size, 100.f, location);
+	trace.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	trace.useProgram(0);
+	trace.uniform(1, GL_FLOAT_MAT4, matrix);
+	trace.uniform(0, GL_FLOAT_MAT4, matrix);
+	trace.uniform(2, GL_FLOAT_MAT3, matrix);
+	trace.drawRanges(0, ranges, first, count);
+	trace.uniform(0, GL_FLOAT_MAT4, matrix);
+	trace.uniform(2, GL_FLOAT_MAT3, matrix);
+	trace.draw(1);
+	trace.present();
+}
+
+int main()
+{
+	const char* const name("trace_test.trc");
+	const char* const bad("trace_bad.trc");
+
+	std::vector<Object::Vertex> vertex;
+	std::vector<GLuint> index;
+	sphereVertex(vertex, 16, 8);
+	sphereIndex(index, 16, 8);
+
+	const GLuint first[] = { 0, 30, 96 };
+	const GLsizei count[] = { 12, 6, 24 };
+	const int frames(50);
+
+	// 書き出しのスレッドに何度も回るように小さなバッファで記録する
+	{
+		TraceRecorder trace(name, 1024);
+		check(trace.isOpen(), "recorder opens the file");
+
+		trace.program(0, "vertex source", "fragment source");
+		trace.uniformName(0, 1, "projection");
+		trace.mesh(0, GL_TRIANGLES, 3, static_cast<GLsizei>(vertex.size()), vertex.data(),
+			static_cast<GLsizei>(index.size()), index.data());
+		trace.mesh(1, GL_LINE_LOOP, 2, 4, vertex.data());
+		trace.enable(GL_DEPTH_TEST);
+		trace.enable(GL_CULL_FACE, false);
+		for (int f = 0; f < frames; ++f) recordFrame(trace, f, first, count, 3);
+
+		check(trace.getFrameCount() == frames, "frame count");
+	}
+
+	// 読み戻して比べる
+	const std::vector<Command> command(readAll(name));
+	check(command.size() == 6 + frames * 12, "every command is read back");
+	if (command.size() == 6 + frames * 12)
+	{
+		const Command& program(command[0]);
+		check(program.op == TraceProgram && program.get<GLuint>(4) == 13 && program.get<GLuint>(8) == 15
+			&& std::string(&program.argument[12], 28) == "vertex sourcefragment source", "program");
+
+		check(command[1].op == TraceUniformName && command[1].get<GLint>(4) == 1
+			&& std::string(&command[1].argument[8], command[1].argument.size() - 8) == "projection", "uniform name");
+
+		const Command& mesh(command[2]);
+		const std::size_t vertexBytes(vertex.size() * sizeof(Object::Vertex));
+		check(mesh.op == TraceMesh && mesh.get<GLenum>(4) == GL_TRIANGLES && mesh.get<GLint>(8) == 3
+			&& mesh.get<GLsizei>(12) == static_cast<GLsizei>(vertex.size())
+			&& mesh.get<GLsizei>(16) == static_cast<GLsizei>(index.size())
+			&& mesh.argument.size() == 20 + vertexBytes + index.size() * sizeof(GLuint)
+			&& memcmp(&mesh.argument[20], vertex.data(), vertexBytes) == 0
+			&& memcmp(&mesh.argument[20 + vertexBytes], index.data(), index.size() * sizeof(GLuint)) == 0, "indexed mesh");
+		check(command[3].op == TraceMesh && command[3].get<GLsizei>(16) == 0
+			&& command[3].argument.size() == 20 + 4 * sizeof(Object::Vertex), "mesh without indices");
+
+		check(command[4].op == TraceEnable && command[4].get<GLenum>(0) == GL_DEPTH_TEST && command[4].get<GLuint>(4) == 1
+			&& command[5].op == TraceEnable && command[5].get<GLuint>(4) == 0, "enable");
+
+		const GLuint expected[] = { TraceFrame, TraceInput, TraceClear, TraceUseProgram, TraceUniform, TraceUniform,
+			TraceUniform, TraceDrawRanges, TraceUniform, TraceUniform, TraceDraw, TracePresent };
+		bool order(true), values(true);
+		for (int f = 0; f < frames; ++f)
+		{
+			const Command* const c(&command[6 + f * 12]);
+			for (int i = 0; i < 12; ++i) order = order && c[i].op == expected[i];
+			if (!order) break;
+
+			values = values && c[0].get<double>(0) == f * 0.016
+				&& c[1].get<GLfloat>(0) == 640.f && c[1].get<GLfloat>(8) == 100.f && c[1].get<GLfloat>(16) == -0.5f
+				&& c[4].get<GLint>(0) == 1 && c[4].get<GLenum>(4) == GL_FLOAT_MAT4 && c[4].argument.size() == 8 + 64
+				&& c[4].get<GLfloat>(8 + 15 * 4) == static_cast<GLfloat>(f * 16 + 15)
+				&& c[6].get<GLenum>(4) == GL_FLOAT_MAT3 && c[6].argument.size() == 8 + 36
+				&& c[7].get<GLsizei>(4) == 3 && c[7].get<GLuint>(8 + 8) == 30 && c[7].get<GLsizei>(8 + 20) == 24
+				&& c[10].get<GLuint>(0) == 1 && c[11].argument.empty();
+		}
+		check(order, "frame commands keep their order");
+		check(values, "frame command arguments");
+	}
+
+	// 途中で切れたトレースは最後のコマンドを捨てる
+	{
+		std::ifstream in(name, std::ios::binary);
+		std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		std::ofstream out(bad, std::ios::binary);
+		out.write(data.data(), data.size() - 3);
+		out.close();
+		check(readAll(bad).size() == command.size() - 1, "truncated trace drops the last command");
+
+		data[0] = 'X';
+		std::ofstream header(bad, std::ios::binary);
+		header.write(data.data(), data.size());
+		header.close();
+		TraceReader reader;
+		check(!reader.load(bad), "bad magic is rejected");
+	}
+
+	// 再生しない形状
+	{
+		const GLsizei n(static_cast<GLsizei>(vertex.size()));
+		check(TracePlayer::checkMesh(GL_TRIANGLES, 3, n, static_cast<GLsizei>(index.size()), index.data()), "valid mesh");
+		check(TracePlayer::checkMesh(GL_LINE_LOOP, 2, 4, 0, NULL), "valid mesh without indices");
+		check(!TracePlayer::checkMesh(0x1234, 3, n, static_cast<GLsizei>(index.size()), index.data()), "bad mode is rejected");
+		check(!TracePlayer::checkMesh(GL_TRIANGLES, 0, n, 0, NULL), "size 0 is rejected");
+		check(!TracePlayer::checkMesh(GL_TRIANGLES, 5, n, 0, NULL), "size 5 is rejected");
+
+		std::vector<GLuint> outside(index);
+		outside[7] = static_cast<GLuint>(n);
+		check(!TracePlayer::checkMesh(GL_TRIANGLES, 3, n, static_cast<GLsizei>(outside.size()), outside.data()),
+			"index out of range is rejected");
+	}
+
+	// 描画スレッドで記録にかかる時間 (書き出しは別スレッド)
+	{
+		std::vector<GLuint> manyFirst(200);
+		std::vector<GLsizei> manyCount(200, 12);
+		for (std::size_t i = 0; i < manyFirst.size(); ++i) manyFirst[i] = static_cast<GLuint>(i * 24);
+
+		const int passes(20000);
+		std::size_t bytes(0);
+		for (const GLsizei ranges : { 3, 200 })
+		{
+			const Clock::time_point start(Clock::now());
+			Clock::time_point recorded;
+			{
+				TraceRecorder trace(name);
+				for (int f = 0; f < passes; ++f) recordFrame(trace, f, manyFirst.data(), manyCount.data(), ranges);
+				recorded = Clock::now();
+				bytes = trace.getByteCount();
+			}
+			const double us(std::chrono::duration<double, std::micro>(recorded - start).count());
+			const double total(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+			std::cout << "record: " << ranges << " ranges, " << us / passes << " us/frame on the draw thread, "
+				<< bytes / passes << " bytes/frame, written at " << bytes / total << " MB/s" << std::endl;
+		}
+	}
+
+	std::remove(name);
+	std::remove(bad);
+
+	std::cout << (failed ? "FAILED" : "OK") << std::endl;
+	return failed ? 1 : 0;
+}